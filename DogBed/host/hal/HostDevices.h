@@ -0,0 +1,180 @@
+#ifndef _HOSTDEVICES_H_
+#define _HOSTDEVICES_H_
+
+/*
+ *  Project: DogBed
+ *  Description: Simulated parts for the host buses, a BME280 that always
+ *               has a reading ready and an SSD1306 that keeps its own copy
+ *               of the screen, so tests can check what really arrived
+ *  Author: David Barbour
+ */
+
+#include "HostHal.h"
+#include <vector>
+
+// BME280 on I2C, registers as in the datasheet. The calibration is the
+// worked example from the datasheet, raw 519888 reads as 25.08C
+class FakeBME280 : public HostI2CDevice {
+
+  uint8_t _registers[256];
+  uint8_t _pointer;
+
+  public:
+    FakeBME280() {
+      static const uint8_t calibration[] = {0x70,0x6B, 0x43,0x67, 0x18,0xFC};
+
+      memset(_registers,0,sizeof(_registers));
+      _registers[0xD0] = 0x60;                  // chip id
+      memcpy(&_registers[0x88],calibration,sizeof(calibration));
+      _registers[0xF7] = 0x80;                  // pressure and humidity skipped
+      _registers[0xFD] = 0x80;
+      setRawTemperature(519888);
+      _pointer = 0;
+    }
+
+    void setRawTemperature(uint32_t raw) {
+      _registers[0xFA] = raw >> 12;
+      _registers[0xFB] = raw >> 4;
+      _registers[0xFC] = (raw & 0x0F) << 4;
+    }
+
+    void receive(const uint8_t *data, size_t length) {
+      // the first byte picks the register, the rest are written from there on
+      if (length == 0) {
+        return;
+      }
+      _pointer = data[0];
+      for (size_t i=1; i<length; i++) {
+        _registers[_pointer++] = data[i];
+      }
+    }
+
+    uint8_t send() {
+      return _registers[_pointer++];
+    }
+};
+
+// SSD1306 on I2C or 4 wire SPI. Commands are decoded far enough to follow the
+// column and page window, data goes into gram like it does in the controller
+class FakeSSD1306 : public HostI2CDevice, public HostSPIDevice {
+
+  int _dcPin, _csPin;
+  int _command;             // command whose arguments are still coming, or -1
+  int _argsLeft;
+  uint8_t _args[6];
+  int _argCount;
+  int _column0, _column1, _page0, _page1;
+  int _column, _page;
+
+  public:
+    uint8_t gram[128 * 64 / 8];
+    std::vector<uint8_t> commands;    // every command and argument byte, in order
+    unsigned long dataBytes;
+    unsigned long strayBytes;         // SPI bytes sent while CS was high
+
+    FakeSSD1306(int dcPin=-1, int csPin=-1) {
+      _dcPin = dcPin;
+      _csPin = csPin;
+      reset();
+    }
+
+    void reset() {
+      memset(gram,0,sizeof(gram));
+      commands.clear();
+      dataBytes = strayBytes = 0;
+      _command = -1;
+      _argsLeft = _argCount = 0;
+      _column0 = _column = 0;
+      _column1 = 127;
+      _page0 = _page = 0;
+      _page1 = 7;
+    }
+
+    // I2C, the control byte says whether commands or data follow
+    void receive(const uint8_t *data, size_t length) {
+      bool isData;
+
+      if (length == 0) {
+        return;
+      }
+      isData = data[0] & 0x40;
+      for (size_t i=1; i<length; i++) {
+        if (isData) {
+          writeData(data[i]);
+        }
+        else {
+          writeCommand(data[i]);
+        }
+      }
+    }
+
+    // SPI, D/C says which
+    uint8_t transfer(uint8_t data) {
+      if (_csPin >= 0 && hostHal::pinLevel(_csPin) != LOW) {
+        strayBytes++;
+        return 0xFF;
+      }
+      if (hostHal::pinLevel(_dcPin) == HIGH) {
+        writeData(data);
+      }
+      else {
+        writeCommand(data);
+      }
+      return 0xFF;
+    }
+
+  private:
+    static int argumentCount(uint8_t command) {
+      switch (command) {
+        case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+        case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+          return 1;
+        case 0x21: case 0x22: case 0xA3:
+          return 2;
+        case 0x29: case 0x2A:
+          return 5;
+        case 0x26: case 0x27:
+          return 6;
+      }
+      return 0;
+    }
+
+    void writeCommand(uint8_t c) {
+      commands.push_back(c);
+      if (_command < 0) {
+        _argsLeft = argumentCount(c);
+        _argCount = 0;
+        if (_argsLeft) {
+          _command = c;
+        }
+        return;
+      }
+      _args[_argCount++] = c;
+      if (--_argsLeft) {
+        return;
+      }
+      if (_command == 0x21) {
+        _column0 = _column = _args[0] & 0x7F;
+        _column1 = _args[1] & 0x7F;
+      }
+      else if (_command == 0x22) {
+        _page0 = _page = _args[0] & 0x07;
+        _page1 = _args[1] & 0x07;
+      }
+      _command = -1;
+    }
+
+    void writeData(uint8_t d) {
+      dataBytes++;
+      gram[_page * 128 + _column] = d;
+      if (_column == _column1) {
+        _column = _column0;
+        _page = (_page == _page1) ? _page0 : _page + 1;
+      }
+      else {
+        _column++;
+      }
+    }
+};
+
+#endif // _HOSTDEVICES_H_
@@ -0,0 +1,769 @@
+/*
+ *  Project: DogBed
+ *  Description: The simulated device behind the host Particle.h, a clock,
+ *               pins with interrupts, I2C and SPI buses that hand their
+ *               bytes to HostI2CDevice/HostSPIDevice objects, software
+ *               timers, threads and a TCP network that always answers
+ *  Author: David Barbour
+ */
+
+#include "HostHal.h"
+
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+USBSerial Serial;
+Logger Log;
+WiFiClass WiFi;
+TwoWire Wire;
+SPIClass SPI(HAL_SPI_INTERFACE1);
+SPIClass SPI1(HAL_SPI_INTERFACE2);
+
+namespace hostHal {
+  BusCounters i2c;
+  BusCounters spi;
+  BusCounters tcp;
+  unsigned long i2cOverflows;
+  unsigned long i2cHz = 400000;
+  unsigned long spiHz = 8000000;
+  Network network;
+}
+
+// ---- clock
+
+static std::atomic<bool> fakeClock(false);
+static std::atomic<uint64_t> fakeMicros(0);
+static const std::chrono::steady_clock::time_point clockStart = std::chrono::steady_clock::now();
+
+static uint64_t nowMicros() {
+  if (fakeClock) {
+    return fakeMicros;
+  }
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - clockStart).count();
+}
+
+system_tick_t millis() {
+  return (system_tick_t)(nowMicros() / 1000);
+}
+
+system_tick_t micros() {
+  return (system_tick_t)nowMicros();
+}
+
+void delay(unsigned long ms) {
+  if (fakeClock) {
+    hostHal::advance(ms);
+  }
+  else {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  }
+}
+
+// busy, like the device, so time spent in short delays shows up in the profile
+static void spinMicros(uint64_t us) {
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::microseconds(us);
+
+  while (std::chrono::steady_clock::now() < end) {
+  }
+}
+
+void delayMicroseconds(unsigned int us) {
+  if (fakeClock) {
+    fakeMicros += us;
+  }
+  else {
+    spinMicros(us);
+  }
+}
+
+// how long bits take at hz, the caller is held for that long on the real clock.
+// A DMA transfer sleeps instead of spinning, the CPU is free while it runs
+static void busTime(unsigned long bits, unsigned long hz, bool busy=true) {
+  if (hz == 0 || fakeClock) {
+    return;
+  }
+  std::chrono::nanoseconds length((uint64_t)bits * 1000000000ULL / hz);
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + length;
+
+  if (!busy) {
+    std::this_thread::sleep_for(length);
+    return;
+  }
+  while (std::chrono::steady_clock::now() < end) {
+  }
+}
+
+// ---- software timers
+
+struct TimerEntry {
+  Timer *timer;
+  bool active;
+  uint64_t due;
+};
+
+// made on first use, timers are built by other constructors before main(). Never
+// freed, the timer thread can still be looking at them while the program exits
+static std::recursive_mutex &timerLock() {
+  static std::recursive_mutex *mutex = new std::recursive_mutex;
+  return *mutex;
+}
+
+static std::vector<TimerEntry> &timerList() {
+  static std::vector<TimerEntry> *list = new std::vector<TimerEntry>;
+  return *list;
+}
+
+static std::atomic<bool> timerThreadStarted(false);
+
+static TimerEntry *findTimer(Timer *timer) {
+  for (TimerEntry &entry : timerList()) {
+    if (entry.timer == timer) {
+      return &entry;
+    }
+  }
+  return NULL;
+}
+
+static void runTimers(uint64_t now) {
+  std::lock_guard<std::recursive_mutex> lock(timerLock());
+
+  // by index, a callback may start or make timers
+  for (size_t i=0; i<timerList().size(); i++) {
+    if (!timerList()[i].active || timerList()[i].due > now) {
+      continue;
+    }
+    Timer *timer = timerList()[i].timer;
+    if (timer->oneShot()) {
+      timerList()[i].active = false;
+    }
+    else {
+      timerList()[i].due += timer->period() * 1000ULL;
+      if (timerList()[i].due <= now) {
+        timerList()[i].due = now + timer->period() * 1000ULL;
+      }
+    }
+    timer->fire();
+  }
+}
+
+static void startTimerThread() {
+  if (timerThreadStarted.exchange(true)) {
+    return;
+  }
+  std::thread([]() {
+    while (true) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      if (!fakeClock) {
+        runTimers(nowMicros());
+      }
+    }
+  }).detach();
+}
+
+Timer::Timer(unsigned int period, void (*callback)(), bool oneShot)
+  : Timer(period,std::function<void()>(callback),oneShot) {}
+
+Timer::Timer(unsigned int period, std::function<void()> callback, bool oneShot) {
+  std::lock_guard<std::recursive_mutex> lock(timerLock());
+
+  _callback = callback;
+  _period = period;
+  _oneShot = oneShot;
+  timerList().push_back({this,false,0});
+}
+
+Timer::~Timer() {
+  std::lock_guard<std::recursive_mutex> lock(timerLock());
+
+  for (size_t i=0; i<timerList().size(); i++) {
+    if (timerList()[i].timer == this) {
+      timerList().erase(timerList().begin() + i);
+      return;
+    }
+  }
+}
+
+void Timer::start() {
+  std::lock_guard<std::recursive_mutex> lock(timerLock());
+  TimerEntry *entry = findTimer(this);
+
+  entry->active = true;
+  entry->due = nowMicros() + _period * 1000ULL;
+  if (!fakeClock) {
+    startTimerThread();
+  }
+}
+
+void Timer::stop() {
+  std::lock_guard<std::recursive_mutex> lock(timerLock());
+
+  findTimer(this)->active = false;
+}
+
+bool Timer::isActive() {
+  std::lock_guard<std::recursive_mutex> lock(timerLock());
+
+  return findTimer(this)->active;
+}
+
+void hostHal::useFakeClock(system_tick_t startMillis) {
+  fakeMicros = startMillis * 1000ULL;
+  fakeClock = true;
+}
+
+void hostHal::useRealClock() {
+  fakeClock = false;
+}
+
+void hostHal::advance(unsigned long ms) {
+  // a millisecond at a time, so the timers run in order
+  for (unsigned long i=0; i<ms; i++) {
+    fakeMicros += 1000;
+    runTimers(fakeMicros);
+  }
+}
+
+// ---- pins
+
+struct PinState {
+  std::atomic<int> level;
+  std::atomic<int> analog;
+  int mode;
+  int interruptMode;        // -1 when nothing is attached
+  std::function<void()> handler;
+};
+
+// made on first use like the timers, constructors set pin modes before main()
+static PinState *pinStates() {
+  static PinState *states = new PinState[PIN_COUNT]();
+  return states;
+}
+
+static std::mutex pinMutex;
+
+static bool validPin(int pin) {
+  return pin >= 0 && pin < PIN_COUNT;
+}
+
+void hostHal::setPin(int pin, int level) {
+  std::function<void()> handler;
+  int old;
+  int mode;
+
+  if (!validPin(pin)) {
+    return;
+  }
+  level = level ? HIGH : LOW;
+  {
+    std::lock_guard<std::mutex> lock(pinMutex);
+    old = pinStates()[pin].level.exchange(level);
+    mode = pinStates()[pin].interruptMode;
+    handler = pinStates()[pin].handler;
+  }
+  if (old == level || !handler) {
+    return;
+  }
+  if (mode == CHANGE || (mode == RISING && level == HIGH) || (mode == FALLING && level == LOW)) {
+    handler();
+  }
+}
+
+int hostHal::pinLevel(int pin) {
+  return validPin(pin) ? pinStates()[pin].level.load() : LOW;
+}
+
+void hostHal::setAnalog(int pin, int value) {
+  if (validPin(pin)) {
+    pinStates()[pin].analog = value;
+  }
+}
+
+void pinMode(int pin, int mode) {
+  if (!validPin(pin)) {
+    return;
+  }
+  pinStates()[pin].mode = mode;
+  // a pulled up input idles high
+  if (mode == INPUT_PULLUP) {
+    pinStates()[pin].level = HIGH;
+  }
+}
+
+PinMode getPinMode(pin_t pin) {
+  return validPin(pin) ? pinStates()[pin].mode : INPUT;
+}
+
+void digitalWrite(int pin, int value) {
+  hostHal::setPin(pin,value);
+}
+
+int digitalRead(int pin) {
+  return hostHal::pinLevel(pin);
+}
+
+int32_t pinReadFast(pin_t pin) {
+  return hostHal::pinLevel(pin);
+}
+
+int analogRead(int pin) {
+  return validPin(pin) ? pinStates()[pin].analog.load() : 0;
+}
+
+void shiftOut(int dataPin, int clockPin, int bitOrder, uint8_t value) {
+  (void)dataPin; (void)clockPin; (void)bitOrder; (void)value;
+}
+
+bool attachInterrupt(uint16_t pin, std::function<void()> handler, int mode, int8_t priority, uint8_t subPriority) {
+  (void)priority; (void)subPriority;
+  if (!validPin(pin)) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(pinMutex);
+  pinStates()[pin].interruptMode = mode;
+  pinStates()[pin].handler = handler;
+  return true;
+}
+
+void detachInterrupt(uint16_t pin) {
+  if (!validPin(pin)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(pinMutex);
+  pinStates()[pin].interruptMode = -1;
+  pinStates()[pin].handler = nullptr;
+}
+
+void noInterrupts() {}
+void interrupts() {}
+
+// ---- I2C
+
+static HostI2CDevice *i2cDevices[128];
+
+void hostHal::attachI2C(uint8_t address, HostI2CDevice *device) {
+  i2cDevices[address & 0x7F] = device;
+}
+
+TwoWire::TwoWire() {
+  _address = 0;
+  _txLength = 0;
+  _rxLength = _rxPos = 0;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+  _address = address & 0x7F;
+  _txLength = 0;
+}
+
+size_t TwoWire::write(uint8_t data) {
+  // the device drops what doesn't fit in its buffer, so does this
+  if (_txLength >= BUFFER_LENGTH) {
+    hostHal::i2cOverflows++;
+    return 0;
+  }
+  _tx[_txLength++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t length) {
+  size_t written = 0;
+
+  while (written < length && write(data[written])) {
+    written++;
+  }
+  return written;
+}
+
+uint8_t TwoWire::endTransmission(bool stop) {
+  (void)stop;
+  hostHal::i2c.bytes += 1 + _txLength;
+  hostHal::i2c.transactions++;
+  busTime((1 + _txLength) * 9,hostHal::i2cHz);
+  if (!i2cDevices[_address]) {
+    return 2;       // nobody answered the address
+  }
+  i2cDevices[_address]->receive(_tx,_txLength);
+  return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity) {
+  HostI2CDevice *device = i2cDevices[address & 0x7F];
+
+  _rxLength = _rxPos = 0;
+  if (quantity > BUFFER_LENGTH) {
+    quantity = BUFFER_LENGTH;
+  }
+  hostHal::i2c.bytes += 1 + quantity;
+  hostHal::i2c.transactions++;
+  busTime((1 + quantity) * 9,hostHal::i2cHz);
+  if (!device) {
+    return 0;
+  }
+  while (_rxLength < quantity) {
+    _rx[_rxLength++] = device->send();
+  }
+  return quantity;
+}
+
+// ---- SPI
+
+static HostSPIDevice *spiDevices[HAL_PLATFORM_SPI_NUM];
+
+void hostHal::attachSPI(SPIClass &spi, HostSPIDevice *device) {
+  spiDevices[spi.interface()] = device;
+}
+
+uint8_t SPIClass::transfer(uint8_t data) {
+  hostHal::spi.bytes++;
+  hostHal::spi.transactions++;
+  busTime(8,hostHal::spiHz);
+  return spiDevices[_interface] ? spiDevices[_interface]->transfer(data) : 0xFF;
+}
+
+void SPIClass::transfer(const void *tx, void *rx, size_t length, wiring_spi_dma_transfercomplete_callback_t callback) {
+  HostSPIDevice *device = spiDevices[_interface];
+
+  hostHal::spi.bytes += length;
+  hostHal::spi.transactions++;
+
+  if (!callback) {
+    // blocking
+    busTime(length * 8,hostHal::spiHz);
+    for (size_t i=0; i<length; i++) {
+      uint8_t in = device ? device->transfer(tx ? ((const uint8_t *)tx)[i] : 0xFF) : 0xFF;
+      if (rx) {
+        ((uint8_t *)rx)[i] = in;
+      }
+    }
+    return;
+  }
+
+  // DMA, the bytes go out on their own and the callback runs once they are sent
+  std::vector<uint8_t> out((const uint8_t *)tx,(const uint8_t *)tx + length);
+  std::thread([out,rx,device,callback]() {
+    busTime(out.size() * 8,hostHal::spiHz,false);
+    for (size_t i=0; i<out.size(); i++) {
+      uint8_t in = device ? device->transfer(out[i]) : 0xFF;
+      if (rx) {
+        ((uint8_t *)rx)[i] = in;
+      }
+    }
+    callback();
+  }).detach();
+}
+
+int hal_spi_begin_ext(int spi, int mode, int ssPin, hal_spi_config_t *config) {
+  (void)spi; (void)mode; (void)ssPin; (void)config;
+  return 0;
+}
+
+// ---- counters
+
+void hostHal::resetCounters() {
+  i2c = BusCounters();
+  spi = BusCounters();
+  tcp = BusCounters();
+  i2cOverflows = 0;
+}
+
+// ---- network
+
+static std::recursive_mutex &networkMutex = *new std::recursive_mutex;
+static std::atomic<unsigned int> networkEpoch(1);
+
+void hostHal::resetNetwork() {
+  std::lock_guard<std::recursive_mutex> lock(networkMutex);
+
+  network.reachable = true;
+  network.connectMillis = 0;
+  network.failWrites = 0;
+  network.response = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+  network.connects = 0;
+  network.writes = 0;
+  network.sent.clear();
+  dropConnections();
+}
+
+void hostHal::dropConnections() {
+  networkEpoch++;
+}
+
+static struct NetworkReset {
+  NetworkReset() { hostHal::resetNetwork(); }
+} networkReset;
+
+int TCPClient::connect(const char *host, uint16_t port) {
+  (void)host; (void)port;
+
+  // the connect blocks whoever called it, as it does on the device
+  delay(hostHal::network.connectMillis);
+
+  std::lock_guard<std::recursive_mutex> lock(networkMutex);
+  _open = false;
+  _replyDue = false;
+  _received.clear();
+  _receivedPos = 0;
+  if (!hostHal::network.reachable) {
+    return 0;
+  }
+  hostHal::network.connects++;
+  _open = true;
+  _epoch = networkEpoch;
+  return 1;
+}
+
+bool TCPClient::connected() {
+  return _open && _epoch == networkEpoch;
+}
+
+size_t TCPClient::write(const uint8_t *buffer, size_t size) {
+  std::lock_guard<std::recursive_mutex> lock(networkMutex);
+
+  if (!connected()) {
+    return 0;
+  }
+  if (hostHal::network.failWrites > 0) {
+    hostHal::network.failWrites--;
+    _open = false;
+    return 0;
+  }
+  hostHal::tcp.bytes += size;
+  hostHal::tcp.transactions++;
+  hostHal::network.writes++;
+  hostHal::network.sent.append((const char *)buffer,size);
+  if (_replyDue) {
+    _received.append(_reply);
+  }
+  _reply = hostHal::network.response;
+  _replyDue = true;
+  return size;
+}
+
+void TCPClient::receiveReply() {
+  std::lock_guard<std::recursive_mutex> lock(networkMutex);
+
+  if (_replyDue) {
+    _received.append(_reply);
+    _replyDue = false;
+  }
+}
+
+int TCPClient::available() {
+  receiveReply();
+  return _received.length() - _receivedPos;
+}
+
+int TCPClient::read() {
+  receiveReply();
+  return (_receivedPos < _received.length()) ? (uint8_t)_received[_receivedPos++] : -1;
+}
+
+int TCPClient::peek() {
+  receiveReply();
+  return (_receivedPos < _received.length()) ? (uint8_t)_received[_receivedPos] : -1;
+}
+
+// ---- threads
+
+struct Semaphore {
+  std::mutex mutex;
+  std::condition_variable ready;
+  unsigned int count, maxCount;
+};
+
+int os_semaphore_create(os_semaphore_t *semaphore, unsigned int maxCount, unsigned int initialCount) {
+  Semaphore *s = new Semaphore;
+
+  s->count = initialCount;
+  s->maxCount = maxCount;
+  *semaphore = s;
+  return 0;
+}
+
+int os_semaphore_destroy(os_semaphore_t semaphore) {
+  delete (Semaphore *)semaphore;
+  return 0;
+}
+
+int os_semaphore_take(os_semaphore_t semaphore, system_tick_t timeout, bool reserved) {
+  Semaphore *s = (Semaphore *)semaphore;
+  std::unique_lock<std::mutex> lock(s->mutex);
+  (void)reserved;
+
+  if (timeout == CONCURRENT_WAIT_FOREVER) {
+    s->ready.wait(lock,[s]() { return s->count > 0; });
+  }
+  else if (!s->ready.wait_for(lock,std::chrono::milliseconds(timeout),[s]() { return s->count > 0; })) {
+    return 1;
+  }
+  s->count--;
+  return 0;
+}
+
+int os_semaphore_give(os_semaphore_t semaphore, bool reserved) {
+  Semaphore *s = (Semaphore *)semaphore;
+  (void)reserved;
+
+  {
+    std::lock_guard<std::mutex> lock(s->mutex);
+    if (s->count >= s->maxCount) {
+      return 1;
+    }
+    s->count++;
+  }
+  s->ready.notify_one();
+  return 0;
+}
+
+int os_thread_yield() {
+  std::this_thread::yield();
+  return 0;
+}
+
+Thread::Thread(const char *name, std::function<void(void)> function, os_thread_prio_t priority, size_t stackSize) {
+  (void)name; (void)priority; (void)stackSize;
+  std::thread(function).detach();
+}
+
+// ---- printing
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t written = 0;
+
+  for (size_t i=0; i<size; i++) {
+    written += write(buffer[i]);
+  }
+  return written;
+}
+
+size_t Print::print(long value) {
+  char text[24];
+
+  snprintf(text,sizeof(text),"%ld",value);
+  return write(text);
+}
+
+size_t Print::print(unsigned long value) {
+  char text[24];
+
+  snprintf(text,sizeof(text),"%lu",value);
+  return write(text);
+}
+
+size_t Print::print(double value, int digits) {
+  char text[48];
+
+  snprintf(text,sizeof(text),"%.*f",digits,value);
+  return write(text);
+}
+
+size_t Print::vprintf(const char *format, va_list args) {
+  char text[256];
+  va_list copy;
+  int length;
+
+  va_copy(copy,args);
+  length = vsnprintf(text,sizeof(text),format,copy);
+  va_end(copy);
+  if (length < 0) {
+    return 0;
+  }
+  if ((size_t)length < sizeof(text)) {
+    return write((const uint8_t *)text,length);
+  }
+  std::vector<char> big(length + 1);
+  vsnprintf(big.data(),big.size(),format,args);
+  return write((const uint8_t *)big.data(),length);
+}
+
+size_t Print::printf(const char *format, ...) {
+  va_list args;
+  size_t written;
+
+  va_start(args,format);
+  written = vprintf(format,args);
+  va_end(args);
+  return written;
+}
+
+size_t USBSerial::write(uint8_t c) {
+  return fputc(c,stdout) == EOF ? 0 : 1;
+}
+
+static void logLine(const char *level, const char *format, va_list args) {
+  fprintf(stderr,"%s: ",level);
+  vfprintf(stderr,format,args);
+  fputc('\n',stderr);
+}
+
+void Logger::trace(const char *format, ...) { va_list args; va_start(args,format); logLine("TRACE",format,args); va_end(args); }
+void Logger::info(const char *format, ...) { va_list args; va_start(args,format); logLine("INFO",format,args); va_end(args); }
+void Logger::warn(const char *format, ...) { va_list args; va_start(args,format); logLine("WARN",format,args); va_end(args); }
+void Logger::error(const char *format, ...) { va_list args; va_start(args,format); logLine("ERROR",format,args); va_end(args); }
+
+// ---- streams
+
+String Stream::readString() {
+  std::string text;
+  int c;
+
+  while ((c = read()) >= 0) {
+    text += (char)c;
+  }
+  return String(text);
+}
+
+String Stream::readStringUntil(char terminator) {
+  std::string text;
+  int c;
+
+  while ((c = read()) >= 0 && c != terminator) {
+    text += (char)c;
+  }
+  return String(text);
+}
+
+size_t Stream::readBytes(char *buffer, size_t length) {
+  size_t count = 0;
+  int c;
+
+  while (count < length && (c = read()) >= 0) {
+    buffer[count++] = (char)c;
+  }
+  return count;
+}
+
+bool Stream::find(const char *target) {
+  return findUntil(target,NULL);
+}
+
+bool Stream::findUntil(const char *target, const char *terminator) {
+  size_t targetLength = strlen(target);
+  size_t terminatorLength = terminator ? strlen(terminator) : 0;
+  size_t matched = 0, terminatorMatched = 0;
+  int c;
+
+  if (targetLength == 0) {
+    return true;
+  }
+  while ((c = read()) >= 0) {
+    // the targets are short, going back to the start on a mismatch is enough
+    if (c == target[matched] || c == target[matched = 0]) {
+      if (++matched == targetLength) {
+        return true;
+      }
+    }
+    if (terminatorLength) {
+      if (c == terminator[terminatorMatched] || c == terminator[terminatorMatched = 0]) {
+        if (++terminatorMatched == terminatorLength) {
+          return false;
+        }
+      }
+    }
+  }
+  return false;
+}
@@ -0,0 +1,87 @@
+#ifndef _HOSTHAL_H_
+#define _HOSTHAL_H_
+
+/*
+ *  Project: DogBed
+ *  Description: The side of the host HAL the harness and tests see. Pins
+ *               are set here, devices are put on the buses, the network
+ *               can be made slow or broken, and every bus counts its bytes
+ *  Author: David Barbour
+ */
+
+#include "Particle.h"
+
+/* Usage:
+ * hostHal::useFakeClock(0);            // millis() only moves when advance() or delay() moves it
+ * hostHal::attachI2C(0x76, &bme);      // a HostI2CDevice answers at that address
+ * hostHal::attachSPI(SPI, &display);   // a HostSPIDevice sees every byte sent on SPI
+ * hostHal::setPin(D9, HIGH);           // fires the interrupt attached to D9
+ * hostHal::i2c.bytes                   // what has been moved so far
+ *
+ * The real clock is the default, delay() sleeps and the buses take as long
+ * as their clock rate says, so the loop rate comes out like the device's.
+ */
+
+// something on the I2C bus, receives each transmission whole
+class HostI2CDevice {
+  public:
+    virtual ~HostI2CDevice() {}
+    virtual void receive(const uint8_t *data, size_t length) = 0;
+    virtual uint8_t send() { return 0xFF; }
+};
+
+// something on an SPI bus, called for every byte with the pins as they are
+class HostSPIDevice {
+  public:
+    virtual ~HostSPIDevice() {}
+    virtual uint8_t transfer(uint8_t data) = 0;
+};
+
+namespace hostHal {
+
+  struct BusCounters {
+    unsigned long bytes;          // address and data bytes on I2C, data bytes on SPI and TCP
+    unsigned long transactions;   // I2C transmissions and reads, SPI transfers, TCP writes
+  };
+
+  extern BusCounters i2c;
+  extern BusCounters spi;         // SPI and SPI1 together
+  extern BusCounters tcp;
+  extern unsigned long i2cOverflows;   // transmissions longer than the Wire buffer
+
+  // bus speeds used to work out how long a transfer takes, 0 makes it instant
+  extern unsigned long i2cHz;
+  extern unsigned long spiHz;
+
+  void resetCounters();
+
+  // clock
+  void useFakeClock(system_tick_t startMillis);
+  void useRealClock();
+  void advance(unsigned long ms);       // fake clock only, runs the timers that come due
+
+  // pins, a change fires the interrupt attached to the pin
+  void setPin(int pin, int level);
+  int pinLevel(int pin);
+  void setAnalog(int pin, int value);
+
+  // buses
+  void attachI2C(uint8_t address, HostI2CDevice *device);
+  void attachSPI(SPIClass &spi, HostSPIDevice *device);
+
+  // network, every host answers unless told otherwise
+  struct Network {
+    bool reachable;               // connect() succeeds
+    unsigned long connectMillis;  // how long a connect() takes, like an outlet that is slow to answer
+    int failWrites;               // this many writes fail and close the connection
+    std::string response;         // what the other side answers, once per request
+    unsigned long connects;
+    unsigned long writes;         // writes that went through
+    std::string sent;             // everything those writes sent
+  };
+  extern Network network;
+  void resetNetwork();
+  void dropConnections();         // the other side closes every open connection
+}
+
+#endif // _HOSTHAL_H_
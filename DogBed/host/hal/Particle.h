@@ -0,0 +1,371 @@
+#ifndef _HOST_PARTICLE_H_
+#define _HOST_PARTICLE_H_
+
+/*
+ *  Project: DogBed
+ *  Description: Just enough of the Particle Device OS API to build the bed
+ *               and its libraries on a Linux host. The pins, buses, clock
+ *               and network are simulated in HostHal.cpp, see HostHal.h
+ *               for how a harness or test drives them
+ *  Author: David Barbour
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <functional>
+#include <mutex>
+#include <string>
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef uint16_t pin_t;
+typedef int PinMode;
+
+// the clock is 32 bits like the device, so code sees millis() wrap the same way
+typedef uint32_t system_tick_t;
+
+#define PLATFORM_ID 32      // builds the P2 paths of the libraries
+
+#define HIGH 1
+#define LOW 0
+
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define INPUT_PULLDOWN 3
+
+#define CHANGE 2
+#define RISING 3
+#define FALLING 4
+
+#define D0 0
+#define D1 1
+#define D2 2
+#define D3 3
+#define D4 4
+#define D5 5
+#define D6 6
+#define D7 7
+#define D8 8
+#define D9 9
+#define D10 10
+#define A0 11
+#define A1 12
+#define A2 13
+#define A5 14
+#define PIN_COUNT 32
+
+#define MSBFIRST 1
+#define LSBFIRST 0
+#define SPI_MODE0 0
+#define SPI_CLOCK_DIV8 8
+
+#define SYSTEM_MODE(mode)
+#define ATOMIC_BLOCK()
+#define waitFor(condition, timeout)
+
+// time
+system_tick_t millis();
+system_tick_t micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// pins
+void pinMode(int pin, int mode);
+PinMode getPinMode(pin_t pin);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+int32_t pinReadFast(pin_t pin);
+int analogRead(int pin);
+void shiftOut(int dataPin, int clockPin, int bitOrder, uint8_t value);
+
+// interrupts, the handlers run when a harness changes a pin with hostHal::setPin()
+bool attachInterrupt(uint16_t pin, std::function<void()> handler, int mode, int8_t priority=-1, uint8_t subPriority=0);
+template <typename T>
+bool attachInterrupt(uint16_t pin, void (T::*handler)(), T *instance, int mode, int8_t priority=-1, uint8_t subPriority=0) {
+  return attachInterrupt(pin,[handler,instance]() { (instance->*handler)(); },mode,priority,subPriority);
+}
+void detachInterrupt(uint16_t pin);
+void noInterrupts();
+void interrupts();
+inline void __enable_irq() {}
+inline void __disable_irq() {}
+
+template <class T> T min(T a, T b) { return (a < b) ? a : b; }
+template <class T> T max(T a, T b) { return (a > b) ? a : b; }
+
+class String {
+  std::string _text;
+
+  public:
+    String() {}
+    String(const char *text) : _text(text ? text : "") {}
+    String(const std::string &text) : _text(text) {}
+    String(char c) : _text(1,c) {}
+    String(int value) : _text(std::to_string(value)) {}
+    String(unsigned int value) : _text(std::to_string(value)) {}
+    String(long value) : _text(std::to_string(value)) {}
+    String(unsigned long value) : _text(std::to_string(value)) {}
+
+    String &operator+=(const String &text) { _text += text._text; return *this; }
+    String &operator+=(const char *text) { _text += text; return *this; }
+    String &operator+=(char c) { _text += c; return *this; }
+    String operator+(const String &text) const { return String(_text + text._text); }
+    String operator+(const char *text) const { return String(_text + text); }
+    bool operator==(const String &text) const { return _text == text._text; }
+    bool operator==(const char *text) const { return _text == text; }
+    bool operator!=(const char *text) const { return _text != text; }
+
+    unsigned int length() const { return _text.length(); }
+    const char *c_str() const { return _text.c_str(); }
+    char charAt(unsigned int i) const { return (i < _text.length()) ? _text[i] : 0; }
+    int indexOf(const char *text, unsigned int from=0) const {
+      size_t at = _text.find(text,from);
+      return (at == std::string::npos) ? -1 : (int)at;
+    }
+    String substring(unsigned int from, unsigned int to) const {
+      return String(_text.substr(from,(to > from) ? to - from : 0));
+    }
+    String substring(unsigned int from) const { return String(_text.substr(min<size_t>(from,_text.length()))); }
+    long toInt() const { return atol(_text.c_str()); }
+};
+
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    size_t write(const char *text) { return write((const uint8_t *)text,strlen(text)); }
+
+    size_t print(const char *text) { return write(text); }
+    size_t print(const String &text) { return write(text.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int value) { return print((long)value); }
+    size_t print(unsigned int value) { return print((unsigned long)value); }
+    size_t print(long value);
+    size_t print(unsigned long value);
+    size_t print(double value, int digits=2);
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(T value) { return print(value) + println(); }
+
+    size_t printf(const char *format, ...) __attribute__((format(printf,2,3)));
+    size_t vprintf(const char *format, va_list args);
+};
+
+// the data is all there already on the host, so nothing waits for more to arrive
+class Stream : public Print {
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    String readString();
+    String readStringUntil(char terminator);
+    size_t readBytes(char *buffer, size_t length);
+    bool find(const char *target);
+    bool findUntil(const char *target, const char *terminator);
+};
+
+class USBSerial : public Stream {
+  public:
+    void begin(long speed=9600) { (void)speed; }
+    bool isConnected() { return true; }
+    size_t write(uint8_t c);
+    using Print::write;
+    int available() { return 0; }
+    int read() { return -1; }
+    int peek() { return -1; }
+};
+extern USBSerial Serial;
+
+class Logger {
+  public:
+    void trace(const char *format, ...) __attribute__((format(printf,2,3)));
+    void info(const char *format, ...) __attribute__((format(printf,2,3)));
+    void warn(const char *format, ...) __attribute__((format(printf,2,3)));
+    void error(const char *format, ...) __attribute__((format(printf,2,3)));
+};
+extern Logger Log;
+
+class WiFiClass {
+  public:
+    void on() {}
+    void off() {}
+    void clearCredentials() {}
+    void setCredentials(const char *ssid) { (void)ssid; }
+    void connect() {}
+    bool connecting() { return false; }
+    bool ready() { return true; }
+};
+extern WiFiClass WiFi;
+
+// I2C, every transmission and read goes to the HostI2CDevice at that address
+class TwoWire {
+  static const size_t BUFFER_LENGTH = 32;
+
+  std::recursive_mutex _mutex;
+  uint8_t _address;
+  uint8_t _tx[BUFFER_LENGTH];
+  size_t _txLength;
+  uint8_t _rx[BUFFER_LENGTH];
+  size_t _rxLength, _rxPos;
+
+  public:
+    TwoWire();
+    void begin() {}
+    void setClock(uint32_t speed) { (void)speed; }
+    void beginTransmission(uint8_t address);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t *data, size_t length);
+    uint8_t endTransmission(bool stop=true);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity);
+    int available() { return _rxLength - _rxPos; }
+    int read() { return (_rxPos < _rxLength) ? _rx[_rxPos++] : -1; }
+
+    bool lock() { _mutex.lock(); return true; }
+    bool unlock() { _mutex.unlock(); return true; }
+    bool try_lock() { return _mutex.try_lock(); }
+};
+extern TwoWire Wire;
+
+#define WITH_LOCK(lockable) for (bool __todo = true; __todo; ) for (std::lock_guard<decltype(lockable)> __lock((lockable)); __todo; __todo=0)
+
+enum {
+  HAL_SPI_INTERFACE1 = 0,
+  HAL_SPI_INTERFACE2 = 1,
+  HAL_PLATFORM_SPI_NUM = 2
+};
+enum {
+  SCK = 20, MISO = 21, SCK1 = 22, MISO1 = 23,
+  PIN_INVALID = 0xff
+};
+enum {
+  HAL_SPI_CONFIG_VERSION = 1,
+  HAL_SPI_CONFIG_FLAG_MOSI_ONLY = 1,
+  SPI_MODE_MASTER = 0
+};
+struct hal_spi_config_t {
+  uint16_t size;
+  uint16_t version;
+  uint32_t flags;
+};
+int hal_spi_begin_ext(int spi, int mode, int ssPin, hal_spi_config_t *config);
+
+struct SPISettings {
+  SPISettings() {}
+  SPISettings(unsigned int clock, int bitOrder, int dataMode) { (void)clock; (void)bitOrder; (void)dataMode; }
+};
+
+typedef void (*wiring_spi_dma_transfercomplete_callback_t)(void);
+
+// SPI, bytes go to the HostSPIDevice on the bus. A transfer with a callback
+// is DMA, it returns right away and the callback runs from another thread
+class SPIClass {
+  int _interface;
+
+  public:
+    SPIClass(int interface) : _interface(interface) {}
+    void begin() {}
+    void end() {}
+    void beginTransaction() {}
+    void beginTransaction(SPISettings settings) { (void)settings; }
+    void endTransaction() {}
+    void setBitOrder(int order) { (void)order; }
+    void setClockDivider(int divider) { (void)divider; }
+    void setClockSpeed(unsigned int speed) { (void)speed; }
+    void setDataMode(int mode) { (void)mode; }
+    int interface() { return _interface; }
+    uint8_t transfer(uint8_t data);
+    void transfer(const void *tx, void *rx, size_t length, wiring_spi_dma_transfercomplete_callback_t callback);
+};
+extern SPIClass SPI;
+extern SPIClass SPI1;
+
+// TCP, connections go to the simulated network in HostHal
+class TCPClient : public Stream {
+  bool _open;
+  bool _replyDue;           // a request went out, the answer shows up when it is read
+  std::string _reply;       // the answer to it, as the network had it when it was sent
+  unsigned int _epoch;      // the network epoch it was opened in, see hostHal::dropConnections()
+  std::string _received;
+  size_t _receivedPos;
+
+  public:
+    TCPClient() : _open(false), _replyDue(false), _epoch(0), _receivedPos(0) {}
+    int connect(const char *host, uint16_t port);
+    bool connected();
+    void stop() { _open = false; }
+    int status() { return connected(); }
+    size_t write(uint8_t c) { return write(&c,1); }
+    size_t write(const uint8_t *buffer, size_t size);
+    using Print::write;
+    int available();
+    int read();
+    int peek();
+
+  private:
+    void receiveReply();
+};
+
+// software timers, run from one timer thread like the device (or from
+// hostHal::advance() on the fake clock)
+class Timer {
+  std::function<void()> _callback;
+  unsigned int _period;
+  bool _oneShot;
+
+  public:
+    Timer(unsigned int period, void (*callback)(), bool oneShot=false);
+    template <typename T>
+    Timer(unsigned int period, void (T::*callback)(), T &instance, bool oneShot=false)
+      : Timer(period,std::function<void()>([callback,&instance]() { (instance.*callback)(); }),oneShot) {}
+    Timer(unsigned int period, std::function<void()> callback, bool oneShot=false);
+    ~Timer();
+    void start();
+    void stop();
+    void reset() { start(); }
+    bool isActive();
+    void changePeriod(unsigned int period) { _period = period; start(); }
+
+    // called by the timer service
+    unsigned int period() { return _period; }
+    bool oneShot() { return _oneShot; }
+    void fire() { _callback(); }
+};
+
+// threads and semaphores
+typedef void *os_semaphore_t;
+typedef int os_thread_prio_t;
+#define OS_THREAD_PRIORITY_DEFAULT 2
+#define OS_THREAD_STACK_SIZE_DEFAULT 3072
+#define CONCURRENT_WAIT_FOREVER ((system_tick_t)-1)
+
+int os_semaphore_create(os_semaphore_t *semaphore, unsigned int maxCount, unsigned int initialCount);
+int os_semaphore_destroy(os_semaphore_t semaphore);
+int os_semaphore_take(os_semaphore_t semaphore, system_tick_t timeout, bool reserved);
+int os_semaphore_give(os_semaphore_t semaphore, bool reserved);
+int os_thread_yield();
+
+class Thread {
+  public:
+    Thread(const char *name, std::function<void(void)> function,
+           os_thread_prio_t priority=OS_THREAD_PRIORITY_DEFAULT, size_t stackSize=OS_THREAD_STACK_SIZE_DEFAULT);
+};
+
+class Mutex {
+  std::mutex _mutex;
+
+  public:
+    void lock() { _mutex.lock(); }
+    bool trylock() { return _mutex.try_lock(); }
+    bool try_lock() { return _mutex.try_lock(); }
+    void unlock() { _mutex.unlock(); }
+};
+
+#endif // _HOST_PARTICLE_H_
@@ -0,0 +1,113 @@
+/*
+ *  Project: DogBed
+ *  Description: Runs the bed's setup() and loop() against the host HAL and
+ *               reports loops/sec, the time each subsystem takes and the
+ *               bytes moved on each bus, the same report profileLoop prints
+ *               on the device. A short script pushes the joystick, moves
+ *               the dog and warms the bed up so every part gets used
+ *  Author: David Barbour
+ */
+
+#include "HostHal.h"
+#include "HostDevices.h"
+#include "LoopProfiler.h"
+#include <stdio.h>
+#include <chrono>
+#include <string>
+
+void setup();
+void loop();
+extern LoopProfiler profiler;
+
+// the pins DogBed.cpp uses
+const int JOY_HORZ = A1;
+const int JOY_VERT = A2;
+const int JOY_SWITCH = D6;
+const int MOTION_PIN = D9;
+const int JOY_CENTER = 2048;
+
+FakeBME280 bme280;
+FakeSSD1306 oled;
+
+// one step of the script, when it happens and what it does
+struct ScriptStep {
+  unsigned int at;      // ms after setup()
+  const char *what;
+  void (*action)();
+};
+
+void pressButton() { hostHal::setPin(JOY_SWITCH,LOW); }
+void releaseButton() { hostHal::setPin(JOY_SWITCH,HIGH); }
+void stickUp() { hostHal::setAnalog(JOY_VERT,0); }
+void stickCenter() { hostHal::setAnalog(JOY_VERT,JOY_CENTER); hostHal::setAnalog(JOY_HORZ,JOY_CENTER); }
+void dogMoves() { hostHal::setPin(MOTION_PIN,HIGH); }
+void dogStops() { hostHal::setPin(MOTION_PIN,LOW); }
+void bedWarm() { bme280.setRawTemperature(519888); }   // 25.08C, needs cooling
+void bedCold() { bme280.setRawTemperature(480000); }
+
+const ScriptStep script[] = {
+  {500,   "button, setup screen",   pressButton},
+  {600,   NULL,                     releaseButton},
+  {1000,  "stick up, turn on",      stickUp},
+  {1100,  NULL,                     stickCenter},
+  {12000, "dog moves",              dogMoves},
+  {12500, NULL,                     dogStops},
+  {20000, "bed gets cold",          bedCold},
+  {21000, "dog moves",              dogMoves},
+  {21500, NULL,                     dogStops},
+  {30000, "bed warms up",           bedWarm}
+};
+const int SCRIPT_STEPS = sizeof(script) / sizeof(script[0]);
+
+int main(int argc, char **argv) {
+  unsigned int seconds = 10;
+  unsigned int start, now;
+  unsigned long loops = 0;
+  int next = 0;
+
+  for (int i=1; i<argc; i++) {
+    if (strcmp(argv[i],"--seconds") == 0 && i+1 < argc) {
+      seconds = atoi(argv[++i]);
+    }
+  }
+
+  hostHal::attachI2C(0x76,&bme280);
+  hostHal::attachI2C(0x3C,&oled);
+  stickCenter();
+  // the Hue hub answers, so the bulb follows the ring. The outlets get the same
+  // answer, they never read it
+  const std::string light = "{\"state\":{\"on\":false,\"bri\":0,\"hue\":0}}";
+  hostHal::network.response = "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(light.length()) + "\r\n\r\n" + light;
+
+  setup();
+
+  hostHal::resetCounters();
+  profiler.reset();
+  start = millis();
+  std::chrono::steady_clock::time_point cpuStart = std::chrono::steady_clock::now();
+
+  while ((now = millis() - start) < seconds * 1000) {
+    while (next < SCRIPT_STEPS && script[next].at <= now) {
+      if (script[next].what) {
+        printf("[%5u ms] %s\n",now,script[next].what);
+      }
+      script[next].action();
+      next++;
+    }
+    loop();
+    profiler.loopDone();
+    loops++;
+  }
+  profiler.report();
+
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - cpuStart).count();
+  printf("\nHost run: %lu loops in %.2f s, %.0f loops/sec\n",loops,elapsed,loops / elapsed);
+  printf("Bus totals from the HAL\n");
+  printf("  i2c  %8lu bytes %7lu transactions (%lu overflowed the Wire buffer)\n",
+    hostHal::i2c.bytes,hostHal::i2c.transactions,hostHal::i2cOverflows);
+  printf("  spi  %8lu bytes %7lu transfers\n",hostHal::spi.bytes,hostHal::spi.transactions);
+  printf("  tcp  %8lu bytes %7lu writes, %lu connects\n",hostHal::tcp.bytes,hostHal::tcp.transactions,hostHal::network.connects);
+
+  fflush(stdout);
+  return 0;
+}
@@ -0,0 +1,67 @@
+/*
+ *  Project: DogBed
+ *  Description: The integer temperature path against the datasheet's
+ *               compensation example and against its floating point
+ *               formula, over the range the bed can see. Centi degrees C
+ *               and the conversion to centi degrees F each have to be
+ *               within one count of the float answer
+ *  Author: David Barbour
+ */
+
+#include "HostTest.h"
+#include "HostDevices.h"
+#include "Adafruit_BME280.h"
+#include <math.h>
+#include <stdlib.h>
+
+Adafruit_BME280 bme;
+FakeBME280 sensor;
+
+// the datasheet's calibration, the same words the fake holds at 0x88
+const double DIG_T1 = 27504;
+const double DIG_T2 = 26435;
+const double DIG_T3 = -1000;
+
+// DS 8.1, the double precision compensation, in degrees C
+double floatCelsius(int32_t raw) {
+  double var1 = (raw / 16384.0 - DIG_T1 / 1024.0) * DIG_T2;
+  double var2 = (raw / 131072.0 - DIG_T1 / 8192.0) * (raw / 131072.0 - DIG_T1 / 8192.0) * DIG_T3;
+  return (var1 + var2) / 5120.0;
+}
+
+int main() {
+  int32_t centiC, centiF;
+  int worstC = 0, worstF = 0, difference;
+
+  hostHal::i2cHz = 0;
+  hostHal::attachI2C(0x76,&sensor);
+  CHECK(bme.begin(0x76));
+
+  // the datasheet example, 519888 is 25.08 C
+  sensor.setRawTemperature(519888);
+  CHECK_EQUAL(2508,bme.readTemperatureCenti());
+  CHECK_EQUAL(7714,Adafruit_BME280::centiCelsiusToFahrenheit(2508));
+  CHECK(fabs(bme.readTemperature() - 25.08) < 0.001);
+
+  // -20 C to 60 C, a step that doesn't line up with anything
+  for (int32_t raw=400000; raw<=640000; raw+=37) {
+    sensor.setRawTemperature(raw);
+    centiC = bme.readTemperatureCenti();
+    difference = abs(centiC - (int32_t)lround(floatCelsius(raw) * 100));
+    if (difference > worstC) {worstC = difference;}
+    // the F conversion of the same reading, so only its own rounding counts
+    centiF = Adafruit_BME280::centiCelsiusToFahrenheit(centiC);
+    difference = abs(centiF - (int32_t)lround(centiC * 1.8 + 3200));
+    if (difference > worstF) {worstF = difference;}
+  }
+  printf("worst difference from the float formula, %d centi C, %d centi F\n",worstC,worstF);
+  CHECK(worstC <= 1);
+  CHECK(worstF <= 1);
+
+  // below zero rounds the same way as above it
+  CHECK_EQUAL(-4000,Adafruit_BME280::centiCelsiusToFahrenheit(-4000));
+  CHECK_EQUAL(3198,Adafruit_BME280::centiCelsiusToFahrenheit(-1));
+  CHECK_EQUAL(Adafruit_BME280::TEMPERATURE_INVALID,Adafruit_BME280::centiCelsiusToFahrenheit(Adafruit_BME280::TEMPERATURE_INVALID));
+
+  return testResult();
+}
@@ -0,0 +1,124 @@
+/*
+ *  Project: DogBed
+ *  Description: Runs a scripted stream of events through the bed's own
+ *               transition table. Every action here just records its name,
+ *               so each dispatch can be checked for running exit, action and
+ *               entry once each and in that order, a self transition running
+ *               its entry again, events with no row doing nothing, and the
+ *               machine ending up in the right state
+ *  Author: David Barbour
+ */
+
+#include "HostTest.h"
+#include "BedMachine.h"
+#include <string>
+
+std::string actions;      // names of the actions run since the last check
+
+void record(const char *name) {
+  if (!actions.empty()) {
+    actions += " ";
+  }
+  actions += name;
+}
+
+void enterOff() { record("enterOff"); }
+void enterSetupOnOff() { record("enterSetupOnOff"); }
+void enterSetupCool() { record("enterSetupCool"); }
+void enterSetupHeat() { record("enterSetupHeat"); }
+void enterSetupManual() { record("enterSetupManual"); }
+void enterWaitCool() { record("enterWaitCool"); }
+void enterWaitHeat() { record("enterWaitHeat"); }
+void enterCooling() { record("enterCooling"); }
+void enterHeating() { record("enterHeating"); }
+void exitCooling() { record("exitCooling"); }
+void exitHeating() { record("exitHeating"); }
+void waitCountdown() { record("waitCountdown"); }
+void stopCountdown() { record("stopCountdown"); }
+void raiseCoolingTemp() { record("raiseCoolingTemp"); }
+void lowerCoolingTemp() { record("lowerCoolingTemp"); }
+void raiseHeatingTemp() { record("raiseHeatingTemp"); }
+void lowerHeatingTemp() { record("lowerHeatingTemp"); }
+
+StateMachine<STATE_COUNT,EVT_COUNT> bedMachine(bedStates,bedTransitions,bedDispatch);
+
+// one event, whether it should move the machine, what should run and where it ends up
+struct Step {
+  int event;
+  bool moves;
+  const char *runs;
+  int state;
+};
+
+const Step script[] = {
+  // into setup and across the screens
+  {EVT_BUTTON,      true,  "enterSetupOnOff",                 STATE_SETUP_ONOFF},
+  {EVT_BUTTON,      false, "",                                STATE_SETUP_ONOFF},
+  {EVT_RIGHT,       true,  "enterSetupCool",                  STATE_SETUP_COOL},
+  // self transitions, the action then the entry again to redraw
+  {EVT_UP,          true,  "raiseCoolingTemp enterSetupCool", STATE_SETUP_COOL},
+  {EVT_DOWN,        true,  "lowerCoolingTemp enterSetupCool", STATE_SETUP_COOL},
+  {EVT_RIGHT,       true,  "enterSetupHeat",                  STATE_SETUP_HEAT},
+  {EVT_UP,          true,  "raiseHeatingTemp enterSetupHeat", STATE_SETUP_HEAT},
+  {EVT_HOT_MOTION,  false, "",                                STATE_SETUP_HEAT},
+  {EVT_LEFT,        true,  "enterSetupCool",                  STATE_SETUP_COOL},
+  {EVT_LEFT,        true,  "enterSetupOnOff",                 STATE_SETUP_ONOFF},
+  // turned on, then the thermostat takes over
+  {EVT_UP,          true,  "enterWaitCool",                   STATE_WAIT_COOL},
+  {EVT_HOT_IDLE,    false, "",                                STATE_WAIT_COOL},
+  {EVT_HOT_MOTION,  true,  "stopCountdown enterCooling",      STATE_COOLING},
+  {EVT_HOT_MOTION,  false, "",                                STATE_COOLING},
+  {EVT_COMFORT,     true,  "exitCooling enterWaitCool",       STATE_WAIT_COOL},
+  {EVT_COLD_IDLE,   true,  "stopCountdown enterWaitHeat",     STATE_WAIT_HEAT},
+  {EVT_COLD_MOTION, true,  "stopCountdown enterHeating",      STATE_HEATING},
+  {EVT_HOT_MOTION,  true,  "exitHeating enterCooling",        STATE_COOLING},
+  {EVT_RIGHT,       false, "",                                STATE_COOLING},
+  {EVT_LEFT,        true,  "exitCooling enterSetupOnOff",     STATE_SETUP_ONOFF},
+  // forced heat, the temperature is ignored until it is left
+  {EVT_RIGHT,       true,  "enterSetupCool",                  STATE_SETUP_COOL},
+  {EVT_RIGHT,       true,  "enterSetupHeat",                  STATE_SETUP_HEAT},
+  {EVT_RIGHT,       true,  "enterSetupManual",                STATE_SETUP_MANUAL},
+  {EVT_UP,          true,  "enterHeating",                    STATE_FORCE_HEAT},
+  {EVT_COMFORT,     false, "",                                STATE_FORCE_HEAT},
+  {EVT_LEFT,        true,  "exitHeating enterSetupOnOff",     STATE_SETUP_ONOFF},
+  {EVT_DOWN,        true,  "enterOff",                        STATE_OFF},
+  // not events at all
+  {EVT_NONE,        false, "",                                STATE_OFF},
+  {EVT_COUNT,       false, "",                                STATE_OFF}
+};
+const int SCRIPT_STEPS = sizeof(script) / sizeof(script[0]);
+
+int main() {
+  // nothing happens before start()
+  CHECK(!bedMachine.dispatch(EVT_BUTTON));
+  bedMachine.update();
+  CHECK(actions.empty());
+
+  bedMachine.start(STATE_OFF);
+  CHECK(actions == "enterOff");
+
+  for (int i=0; i<SCRIPT_STEPS; i++) {
+    actions.clear();
+    bool moved = bedMachine.dispatch(script[i].event);
+    if (moved != script[i].moves || actions != script[i].runs || bedMachine.state() != script[i].state) {
+      printf("step %i, event %i: moved %i ran \"%s\" now in %i, expected %i \"%s\" %i\n",i,script[i].event,
+        moved,actions.c_str(),bedMachine.state(),script[i].moves,script[i].runs,script[i].state);
+      testFailures++;
+    }
+  }
+  CHECK_EQUAL(STATE_OFF,bedMachine.state());
+
+  // during runs on every update, only in the states that have one
+  actions.clear();
+  bedMachine.update();
+  CHECK(actions.empty());
+  bedMachine.dispatch(EVT_BUTTON);
+  bedMachine.dispatch(EVT_UP);
+  actions.clear();
+  bedMachine.update();
+  bedMachine.update();
+  CHECK(actions == "waitCountdown waitCountdown");
+  CHECK_EQUAL(STATE_WAIT_COOL,bedMachine.state());
+
+  return testResult();
+}
@@ -0,0 +1,37 @@
+#ifndef _HOSTTEST_H_
+#define _HOSTTEST_H_
+
+/*
+ *  Project: DogBed
+ *  Description: The few checks the host tests need. A failed CHECK prints
+ *               where it was and the test carries on, main() ends with
+ *               return testResult() so ctest sees the failure
+ *  Author: David Barbour
+ */
+
+#include <stdio.h>
+
+static int testFailures = 0;
+
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+      printf("%s:%d: CHECK(%s) failed\n",__FILE__,__LINE__,#condition); \
+      testFailures++; \
+    } \
+  } while (0)
+
+#define CHECK_EQUAL(expected, actual) do { \
+    long long _expected = (expected), _actual = (actual); \
+    if (_expected != _actual) { \
+      printf("%s:%d: CHECK_EQUAL(%s, %s) failed, %lld != %lld\n",__FILE__,__LINE__,#expected,#actual,_expected,_actual); \
+      testFailures++; \
+    } \
+  } while (0)
+
+static int testResult() {
+  printf("%s\n",testFailures ? "FAILED" : "passed");
+  fflush(stdout);
+  return testFailures ? 1 : 0;
+}
+
+#endif // _HOSTTEST_H_
@@ -0,0 +1,106 @@
+/*
+ *  Project: DogBed
+ *  Description: Wemo and Hue requests over the connection pool. A write the
+ *               outlet drops is sent again once on a new connection, and only
+ *               a request that really went out counts as sent. The Hue body
+ *               is exactly Content-Length bytes, and getHue() reads its
+ *               answer from the body it was given. A reused connection
+ *               never hands back what was left of the last answer
+ *  Author: David Barbour
+ */
+
+#include "HostTest.h"
+#include "HostHal.h"
+#include "WemoQueue.h"
+#include "hue.h"
+#include <string>
+
+// pump until the queue is empty, the way loop() would
+void drain(WemoQueue &queue) {
+  for (int i=0; i<100 && queue.pump(); i++) {
+  }
+}
+
+bool endsWith(const std::string &text, const std::string &end) {
+  return text.length() >= end.length() && text.compare(text.length() - end.length(),end.length(),end) == 0;
+}
+
+int main() {
+  // no begin(), so pump() does the sends itself on this thread
+  WemoQueue outlets;
+
+  // a clean send, one connection and one write
+  outlets.write(2,true);
+  drain(outlets);
+  CHECK_EQUAL(1,outlets.sentCount());
+  CHECK_EQUAL(0,outlets.failedCount());
+  CHECK_EQUAL(1,hostHal::network.connects);
+  CHECK_EQUAL(1,hostHal::network.writes);
+  CHECK(endsWith(hostHal::network.sent,"<BinaryState>1</BinaryState></u:SetBinaryState></s:Body></s:Envelope>"));
+
+  // the outlet closes the kept connection under the write, it goes again on a new one
+  hostHal::network.failWrites = 1;
+  outlets.write(2,false);
+  drain(outlets);
+  CHECK_EQUAL(2,outlets.sentCount());
+  CHECK_EQUAL(0,outlets.failedCount());
+  CHECK_EQUAL(2,hostHal::network.connects);
+  CHECK_EQUAL(2,hostHal::network.writes);
+  CHECK(endsWith(hostHal::network.sent,"<BinaryState>0</BinaryState></u:SetBinaryState></s:Body></s:Envelope>"));
+
+  // the retry fails too, so nothing was sent
+  hostHal::network.failWrites = 2;
+  outlets.write(2,true);
+  drain(outlets);
+  CHECK_EQUAL(2,outlets.sentCount());
+  CHECK_EQUAL(1,outlets.failedCount());
+  CHECK_EQUAL(2,hostHal::network.writes);
+
+  // the outlet doesn't answer at all
+  hostHal::network.reachable = false;
+  outlets.write(3,true);
+  drain(outlets);
+  CHECK_EQUAL(2,outlets.sentCount());
+  CHECK_EQUAL(2,outlets.failedCount());
+  hostHal::network.reachable = true;
+
+  // the Hue body goes out with nothing after it, so the hub sees exactly Content-Length bytes
+  hostHal::network.sent.clear();
+  CHECK(setHue(3,true,HueBlue,100,255));
+  const std::string body = "{\"on\":true,\"sat\":255,\"bri\":100,\"hue\":45000}";
+  CHECK(endsWith(hostHal::network.sent,"Content-Length: " + std::to_string(body.length()) + "\r\n" +
+                                       "Content-Type: text/plain;charset=UTF-8\r\n\r\n" + body));
+
+  // and a dropped write to the hub is retried like the outlets
+  hostHal::network.failWrites = 1;
+  hostHal::network.sent.clear();
+  CHECK(setHue(3,false,0,0,0));
+  CHECK_EQUAL(1,httpPool.retries());
+  CHECK(endsWith(hostHal::network.sent,"\r\n\r\n{\"on\":false}"));
+
+  // getHue() parses the body it read, not a stream that is already empty
+  const std::string light = "{\"state\":{\"on\":true,\"bri\":144,\"hue\":13088,\"sat\":212},\"name\":\"Bed\"}";
+  hostHal::network.response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: " +
+                              std::to_string(light.length()) + "\r\n\r\n" + light;
+  hueOn = false;
+  hueBri = hueHue = 0;
+  CHECK(getHue(3));
+  CHECK(hueOn);
+  CHECK_EQUAL(144,hueBri);
+  CHECK_EQUAL(13088,hueHue);
+
+  // wemoRead() reads the answer off the connection its request went out on
+  hostHal::network.response = "HTTP/1.1 200 OK\r\nContent-Length: 40\r\n\r\n<BinaryState>1</BinaryState>";
+  CHECK_EQUAL(1,wemoRead(2));
+
+  // an answer nobody read is still on the kept connection, the next request
+  // on it reads its own answer and not the old one
+  hostHal::network.response = "HTTP/1.1 200 OK\r\nContent-Length: 40\r\n\r\n<BinaryState>0</BinaryState>";
+  CHECK(wemoSend(2,false));
+  hostHal::network.response = "HTTP/1.1 200 OK\r\nContent-Length: 40\r\n\r\n<BinaryState>1</BinaryState>";
+  unsigned int connects = hostHal::network.connects;
+  CHECK_EQUAL(1,wemoRead(2));
+  CHECK_EQUAL(connects,hostHal::network.connects);
+
+  return testResult();
+}
@@ -0,0 +1,68 @@
+/*
+ *  Project: DogBed
+ *  Description: Frames sent from the SSD1306 flush thread. Drawing goes on
+ *               while the last frame is still on the I2C bus, frames that
+ *               come in meanwhile are held and folded into the next one,
+ *               and after waitForFlush() the controller has to show
+ *               exactly what is in the frame buffer. The byte counters the
+ *               two threads share have to agree with the bus
+ *  Author: David Barbour
+ */
+
+#include "HostTest.h"
+#include "HostDevices.h"
+#include "Adafruit_SSD1306.h"
+
+const int BUFFER_SIZE = SSD1306_LCDWIDTH * SSD1306_LCDHEIGHT / 8;
+const int FRAMES = 1500;
+
+Adafruit_SSD1306 display(-1);
+FakeSSD1306 oled;
+
+int main() {
+  unsigned int sent;
+  uint32_t busBytes, busTransactions;
+
+  hostHal::attachI2C(SSD1306_I2C_ADDRESS,&oled);
+  display.begin(SSD1306_SWITCHCAPVCC,SSD1306_I2C_ADDRESS);
+  display.clearDisplay();
+  display.display();
+  CHECK(memcmp(oled.gram,display.getBuffer(),BUFFER_SIZE) == 0);
+
+  display.beginAsync();
+  hostHal::resetCounters();
+  busBytes = display.busBytes();
+  busTransactions = display.busTransactions();
+  srand(3);
+  for (int f=0; f<FRAMES; f++) {
+    int n = rand() % 5;
+    for (int i=0; i<n; i++) {
+      display.fillRect(rand() % 128,rand() % 64,rand() % 30,rand() % 20,rand() % 2);
+    }
+    display.display();
+
+    if (f % 500 == 499) {
+      display.waitForFlush();
+      CHECK(!display.flushing());
+      CHECK(!display.pending());
+      CHECK(memcmp(oled.gram,display.getBuffer(),BUFFER_SIZE) == 0);
+      printf("frame %i, %u held\n",f + 1,(unsigned int)display.coalescedFrames());
+    }
+  }
+
+  // at 400kHz a frame takes longer than drawing one, some have to be held
+  CHECK(display.coalescedFrames() > 0);
+
+  // both threads counted, none of it was lost
+  display.waitForFlush();
+  CHECK_EQUAL(hostHal::i2c.bytes,display.busBytes() - busBytes);
+  CHECK_EQUAL(hostHal::i2c.transactions,display.busTransactions() - busTransactions);
+
+  // nothing new drawn, nothing goes out
+  sent = oled.dataBytes;
+  display.display();
+  display.waitForFlush();
+  CHECK_EQUAL(sent,oled.dataBytes);
+
+  return testResult();
+}
@@ -0,0 +1,85 @@
+/*
+ *  Project: DogBed
+ *  Description: The SSD1306 bitmap blitter has to draw exactly what the
+ *               pixel at a time Adafruit_GFX::drawBitmap() does, clipped
+ *               and rotated. Random bitmaps are drawn both ways into the
+ *               same starting buffer and compared, then the DogBed
+ *               graphics are timed both ways
+ *  Author: David Barbour
+ */
+
+#include "HostTest.h"
+#include "Adafruit_SSD1306.h"
+#include "Graphic.h"
+#include <chrono>
+
+const int BUFFER_SIZE = SSD1306_LCDWIDTH * SSD1306_LCDHEIGHT / 8;
+const int CASES = 20000;
+const int TIMED_RUNS = 20000;
+
+Adafruit_SSD1306 display(-1);
+
+int main() {
+  uint8_t *buffer = display.getBuffer();
+  uint8_t start[BUFFER_SIZE], expected[BUFFER_SIZE];
+  uint8_t bitmap[16 * 80];
+  int mismatches = 0;
+
+  srand(1);
+  for (int t=0; t<CASES; t++) {
+    int w = 1 + rand() % 100, h = 1 + rand() % 80;
+    int x = rand() % 150 - 10, y = rand() % 90 - 10;
+    uint16_t color = rand() % 2;
+
+    for (size_t i=0; i<sizeof(bitmap); i++) {
+      bitmap[i] = rand();
+    }
+    for (int i=0; i<BUFFER_SIZE; i++) {
+      start[i] = rand();
+    }
+    display.setRotation((rand() % 8 == 0) ? 2 : 0);
+
+    memcpy(buffer,start,BUFFER_SIZE);
+    display.Adafruit_GFX::drawBitmap(x,y,bitmap,w,h,color);
+    memcpy(expected,buffer,BUFFER_SIZE);
+
+    memcpy(buffer,start,BUFFER_SIZE);
+    display.drawBitmap(x,y,bitmap,w,h,color);
+    if (memcmp(expected,buffer,BUFFER_SIZE) != 0) {
+      if (mismatches++ < 5) {
+        printf("mismatch drawing %ix%i at %i,%i color %i rotation %i\n",w,h,x,y,color,display.getRotation());
+      }
+    }
+  }
+  CHECK_EQUAL(0,mismatches);
+
+  struct {
+    const char *name;
+    const uint8_t *bitmap;
+    int x, y, w, h;
+  } graphics[] = {
+    {"updown",  graphic_updown,  0,  9, 16,  46},
+    {"onoff",   graphic_onoff,   20, 0, 80,  68},
+    {"hotcold", graphic_hotcold, 9,  5, 110, 51}
+  };
+
+  display.setRotation(0);
+  printf("us per draw over %i draws\n",TIMED_RUNS);
+  for (auto &graphic : graphics) {
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (int i=0; i<TIMED_RUNS; i++) {
+      display.Adafruit_GFX::drawBitmap(graphic.x,graphic.y,graphic.bitmap,graphic.w,graphic.h,WHITE);
+    }
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    for (int i=0; i<TIMED_RUNS; i++) {
+      display.drawBitmap(graphic.x,graphic.y,graphic.bitmap,graphic.w,graphic.h,WHITE);
+    }
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+    double pixel = std::chrono::duration<double,std::micro>(t1 - t0).count() / TIMED_RUNS;
+    double blit = std::chrono::duration<double,std::micro>(t2 - t1).count() / TIMED_RUNS;
+    printf("  %-8s pixel %6.2f  blit %6.2f  %.1fx faster\n",graphic.name,pixel,blit,pixel / blit);
+  }
+
+  return testResult();
+}
@@ -0,0 +1,81 @@
+/*
+ *  Project: DogBed
+ *  Description: SSD1306 commands are batched, the init sequence, a frame's
+ *               window and the scroll and dim settings each go out as one
+ *               I2C transmission that fits the Wire buffer. The display's
+ *               own byte and transaction counters have to agree with what
+ *               the bus saw
+ *  Author: David Barbour
+ */
+
+#include "HostTest.h"
+#include "HostDevices.h"
+#include "Adafruit_SSD1306.h"
+
+Adafruit_SSD1306 display(-1);
+FakeSSD1306 oled;
+
+int main() {
+  hostHal::i2cHz = 0;
+  hostHal::attachI2C(SSD1306_I2C_ADDRESS,&oled);
+
+  // init, one transmission
+  hostHal::resetCounters();
+  display.begin(SSD1306_SWITCHCAPVCC,SSD1306_I2C_ADDRESS);
+  const uint8_t init[] = {0xAE, 0xD5,0x80, 0xA8,0x3F, 0xD3,0x00, 0x40, 0x8D,0x14, 0x20,0x00, 0xA1, 0xC8,
+                          0xDA,0x12, 0x81,0xCF, 0xD9,0xF1, 0xDB,0x40, 0xA4, 0xA6, 0xAF};
+  CHECK_EQUAL(1,hostHal::i2c.transactions);
+  CHECK_EQUAL(sizeof(init),oled.commands.size());
+  CHECK(memcmp(init,oled.commands.data(),sizeof(init)) == 0);
+
+  // a frame, the window in one transmission then 16 data bytes per transmission
+  display.clearDisplay();
+  display.display();
+  hostHal::resetCounters();
+  oled.commands.clear();
+  oled.dataBytes = 0;
+  display.fillRect(50,20,70,30,WHITE);
+  display.display();
+  const uint8_t window[] = {0x21,50,119, 0x22,2,6};
+  CHECK_EQUAL(sizeof(window),oled.commands.size());
+  CHECK(memcmp(window,oled.commands.data(),sizeof(window)) == 0);
+  CHECK_EQUAL(70 * 5,oled.dataBytes);
+  CHECK_EQUAL(1 + (70 * 5 + 15) / 16,hostHal::i2c.transactions);
+  CHECK(memcmp(oled.gram,display.getBuffer(),SSD1306_LCDWIDTH * SSD1306_LCDHEIGHT / 8) == 0);
+
+  // dim and a diagonal scroll, one transmission each
+  hostHal::resetCounters();
+  oled.commands.clear();
+  display.dim(true);
+  display.startscrolldiagleft(0,15);
+  const uint8_t settings[] = {0x81,0x00, 0xA3,0x00,64, 0x2A,0x00,0,0x00,15,0x01, 0x2F};
+  CHECK_EQUAL(2,hostHal::i2c.transactions);
+  CHECK_EQUAL(sizeof(settings),oled.commands.size());
+  CHECK(memcmp(settings,oled.commands.data(),sizeof(settings)) == 0);
+
+  // a list longer than the Wire buffer is split, nothing is lost
+  hostHal::resetCounters();
+  oled.commands.clear();
+  uint8_t many[70];
+  for (size_t i=0; i<sizeof(many); i++) {
+    many[i] = 0xA4;
+  }
+  display.ssd1306_commandList(many,sizeof(many));
+  CHECK_EQUAL(3,hostHal::i2c.transactions);
+  CHECK_EQUAL(sizeof(many),oled.commands.size());
+
+  CHECK_EQUAL(0,hostHal::i2cOverflows);
+
+  // the display counts the same bytes the bus does
+  hostHal::resetCounters();
+  uint32_t before = display.busBytes();
+  uint32_t transactions = display.busTransactions();
+  display.invalidate();
+  display.display();
+  display.dim(false);
+  display.ssd1306_data(0x55);
+  CHECK_EQUAL(hostHal::i2c.bytes,display.busBytes() - before);
+  CHECK_EQUAL(hostHal::i2c.transactions,display.busTransactions() - transactions);
+
+  return testResult();
+}
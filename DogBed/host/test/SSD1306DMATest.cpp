@@ -0,0 +1,120 @@
+/*
+ *  Project: DogBed
+ *  Description: An SSD1306 on hardware SPI sending its frames by DMA. The
+ *               transfer finishes on another thread, the frames held while
+ *               it runs go out after it, CS stays low for every byte, and
+ *               after waitForFlush() the controller shows the frame buffer.
+ *               Only one display may own the DMA completion. Also compares
+ *               full frames sent blocking against DMA, on the host's
+ *               simulated 8 MHz SPI bus, so the numbers show the overlap
+ *               and not what the P2 itself does
+ *  Author: David Barbour
+ */
+
+#include "HostTest.h"
+#include "HostDevices.h"
+#include "Adafruit_SSD1306.h"
+
+const int BUFFER_SIZE = SSD1306_LCDWIDTH * SSD1306_LCDHEIGHT / 8;
+const int FRAMES = 2000;
+const int DC_PIN = D5;
+const int RESET_PIN = D7;
+const int CS_PIN = D10;
+const int TIMED_FRAMES = 300;
+const unsigned int DRAW_MICROS = 800;   // drawing the next frame, about what a screen change costs
+
+Adafruit_SSD1306 display(DC_PIN,RESET_PIN,CS_PIN);
+Adafruit_SSD1306 second(D2,D3,D4);
+Adafruit_SSD1306 i2cDisplay(-1);
+FakeSSD1306 oled(DC_PIN,CS_PIN);
+
+// the CPU busy drawing, the bus carries on by itself only with DMA
+void draw() {
+  unsigned int start = micros();
+
+  while (micros() - start < DRAW_MICROS) {
+  }
+}
+
+struct FrameTiming {
+  unsigned long total;       // us for all the frames, drawing included
+  unsigned long inDisplay;   // us the caller spent inside display()
+};
+
+FrameTiming timeFrames() {
+  FrameTiming timing = {0, 0};
+  unsigned int start, called;
+
+  display.waitForFlush();
+  start = micros();
+  for (int f=0; f<TIMED_FRAMES; f++) {
+    draw();
+    display.invalidate();
+    called = micros();
+    display.display();
+    timing.inDisplay += micros() - called;
+  }
+  display.waitForFlush();
+  timing.total = micros() - start;
+  return timing;
+}
+
+int main() {
+  unsigned long transfers;
+
+  hostHal::attachSPI(SPI,&oled);
+  display.begin();
+  display.clearDisplay();
+  display.display();
+  CHECK(memcmp(oled.gram,display.getBuffer(),BUFFER_SIZE) == 0);
+
+  // DMA only on hardware SPI, and for one display at a time
+  CHECK(!i2cDisplay.setDMA(true));
+  CHECK(display.setDMA(true));
+  CHECK(!second.setDMA(true));
+  CHECK(display.setDMA(true));
+  hostHal::resetCounters();
+  srand(5);
+  for (int f=0; f<FRAMES; f++) {
+    int n = rand() % 4;
+    for (int i=0; i<n; i++) {
+      display.fillRect(rand() % 128,rand() % 64,rand() % 30,rand() % 20,rand() % 2);
+    }
+    display.display();
+
+    if (f % 400 == 399) {
+      display.waitForFlush();
+      CHECK(!display.flushing());
+      CHECK(memcmp(oled.gram,display.getBuffer(),BUFFER_SIZE) == 0);
+      printf("frame %i, %u held\n",f + 1,(unsigned int)display.coalescedFrames());
+    }
+  }
+  CHECK_EQUAL(0,oled.strayBytes);
+
+  // a whole frame is the window commands byte by byte and the data in one transfer
+  display.waitForFlush();
+  transfers = hostHal::spi.transactions;
+  display.invalidate();
+  display.display();
+  display.waitForFlush();
+  CHECK_EQUAL(6 + 1,hostHal::spi.transactions - transfers);
+
+  // whole frames with drawing in between, blocking and then by DMA
+  CHECK(display.setDMA(false));
+  CHECK(second.setDMA(true));
+  CHECK(second.setDMA(false));
+  FrameTiming blocking = timeFrames();
+  CHECK(display.setDMA(true));
+  FrameTiming dma = timeFrames();
+  CHECK(memcmp(oled.gram,display.getBuffer(),BUFFER_SIZE) == 0);
+
+  printf("Full frames on the simulated %lu Hz SPI bus, %u us drawing each\n",hostHal::spiHz,DRAW_MICROS);
+  printf("  blocking  %5lu frames/sec  %5lu us per display()\n",
+    TIMED_FRAMES * 1000000UL / blocking.total,blocking.inDisplay / TIMED_FRAMES);
+  printf("  DMA       %5lu frames/sec  %5lu us per display()\n",
+    TIMED_FRAMES * 1000000UL / dma.total,dma.inDisplay / TIMED_FRAMES);
+  // the frame goes out while the next one is drawn instead of before it
+  CHECK(dma.inDisplay * 2 < blocking.inDisplay);
+
+  return testResult();
+}
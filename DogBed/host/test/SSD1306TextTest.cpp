@@ -0,0 +1,78 @@
+/*
+ *  Project: DogBed
+ *  Description: Characters rendered straight into the SSD1306 pages have
+ *               to match Adafruit_GFX::drawChar(), for every size, color
+ *               and position, on and off a page boundary and off the edge
+ *               of the screen. Then the text sizes the screens use are timed
+ *  Author: David Barbour
+ */
+
+#include "HostTest.h"
+#include "Adafruit_SSD1306.h"
+#include <chrono>
+
+const int BUFFER_SIZE = SSD1306_LCDWIDTH * SSD1306_LCDHEIGHT / 8;
+const int CASES = 50000;
+const int TIMED_CHARS = 200000;
+
+Adafruit_SSD1306 display(-1);
+
+int main() {
+  uint8_t *buffer = display.getBuffer();
+  uint8_t start[BUFFER_SIZE], expected[BUFFER_SIZE];
+  const uint16_t colors[] = {BLACK, WHITE, 0xFFFF, 2};
+  int mismatches = 0;
+
+  srand(2);
+  for (int t=0; t<CASES; t++) {
+    int size = 1 + rand() % 9;
+    int x = rand() % 140 - 8, y = rand() % 80 - 8;
+    unsigned char c = rand();
+    uint16_t color = colors[rand() % 4];
+    uint16_t bg = (rand() % 2) ? color : colors[rand() % 4];   // bg == color is transparent
+
+    for (int i=0; i<BUFFER_SIZE; i++) {
+      start[i] = rand();
+    }
+    display.setRotation((rand() % 8 == 0) ? 1 : 0);
+
+    memcpy(buffer,start,BUFFER_SIZE);
+    display.Adafruit_GFX::drawChar(x,y,c,color,bg,size);
+    memcpy(expected,buffer,BUFFER_SIZE);
+
+    memcpy(buffer,start,BUFFER_SIZE);
+    display.drawChar(x,y,c,color,bg,size);
+    if (memcmp(expected,buffer,BUFFER_SIZE) != 0) {
+      if (mismatches++ < 5) {
+        printf("mismatch drawing %i at %i,%i size %i color %i bg %i\n",c,x,y,size,color,bg);
+      }
+    }
+  }
+  CHECK_EQUAL(0,mismatches);
+
+  struct {
+    int y, size;
+    uint16_t bg;
+  } cases[] = {{8,1,WHITE}, {8,1,BLACK}, {11,1,BLACK}, {11,1,WHITE}, {16,2,BLACK}, {19,2,BLACK}, {20,3,BLACK}};
+
+  display.setRotation(0);
+  printf("chars per ms over %i chars\n",TIMED_CHARS);
+  for (auto &k : cases) {
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (int i=0; i<TIMED_CHARS; i++) {
+      display.Adafruit_GFX::drawChar((i % 16) * 6,k.y,'0' + i % 10,WHITE,k.bg,k.size);
+    }
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    for (int i=0; i<TIMED_CHARS; i++) {
+      display.drawChar((i % 16) * 6,k.y,'0' + i % 10,WHITE,k.bg,k.size);
+    }
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+    double pixel = TIMED_CHARS / std::chrono::duration<double,std::milli>(t1 - t0).count();
+    double page = TIMED_CHARS / std::chrono::duration<double,std::milli>(t2 - t1).count();
+    printf("  size %i at y %2i %-11s pixel %6.0f  page %6.0f  %.1fx faster\n",k.size,k.y,
+      k.bg == WHITE ? "transparent" : "opaque",pixel,page,page / pixel);
+  }
+
+  return testResult();
+}
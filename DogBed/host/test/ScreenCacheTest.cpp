@@ -0,0 +1,83 @@
+/*
+ *  Project: DogBed
+ *  Description: A cached screen comes back exactly as it was drawn, keeping
+ *               only the pages it drew on. Screens that don't fit in the
+ *               pages left are drawn every time, and a forgotten screen is
+ *               drawn again into the room it already had
+ *  Author: David Barbour
+ */
+
+#include "HostTest.h"
+#include "HostHal.h"
+#include "ScreenCache.h"
+
+const int BUFFER_SIZE = SSD1306_LCDWIDTH * SSD1306_LCDHEIGHT / 8;
+
+Adafruit_SSD1306 display(-1);
+int draws = 0;
+int lineY = 40;
+
+// screen n is a bar n+1 pages tall from the top, screen 3 draws nothing,
+// screen 4 is one line that can be moved
+void drawScreen(int screen) {
+  draws++;
+  if (screen == 3) {
+    return;
+  }
+  if (screen == 4) {
+    display.drawFastHLine(0,lineY,128,WHITE);
+    return;
+  }
+  display.fillRect(screen * 10,0,20,(screen + 1) * 8,WHITE);
+}
+
+// what the screen looks like drawn from scratch
+bool matches(int screen) {
+  uint8_t cached[BUFFER_SIZE];
+
+  memcpy(cached,display.getBuffer(),BUFFER_SIZE);
+  display.clearDisplay();
+  drawScreen(screen);
+  draws--;
+  return memcmp(cached,display.getBuffer(),BUFFER_SIZE) == 0;
+}
+
+int main() {
+  // pages 1 + 2 + 3 + 0 + 1 fit in 7, a screen past SCREENS is just drawn
+  ScreenCache<5,7> screens(display,drawScreen);
+
+  for (int pass=0; pass<3; pass++) {
+    for (int screen=0; screen<6; screen++) {
+      // something left over from the last screen must not show through
+      display.fillRect(0,0,128,64,WHITE);
+      screens.show(screen);
+      CHECK(matches(screen));
+    }
+  }
+  CHECK_EQUAL(5,screens.misses());
+  CHECK_EQUAL(10,screens.hits());
+  CHECK_EQUAL(7,screens.pagesUsed());
+  CHECK_EQUAL(5 + 3,draws);
+
+  // the line moves within its page, it is drawn again into the page it had
+  lineY = 44;
+  screens.forget(4);
+  screens.show(4);
+  CHECK(matches(4));
+  CHECK_EQUAL(7,screens.pagesUsed());
+
+  // too small to keep the tall screens, they are drawn every time
+  ScreenCache<3,4> small(display,drawScreen);
+  draws = 0;
+  for (int pass=0; pass<3; pass++) {
+    for (int screen=0; screen<3; screen++) {
+      small.show(screen);
+      CHECK(matches(screen));
+    }
+  }
+  // 0 and 1 fit in 3 pages, 2 needs 3 more
+  CHECK_EQUAL(3,small.pagesUsed());
+  CHECK_EQUAL(2 + 3,draws);
+
+  return testResult();
+}
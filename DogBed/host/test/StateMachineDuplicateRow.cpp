@@ -0,0 +1,36 @@
+/*
+ *  Project: DogBed
+ *  Description: Must not compile. The table has two rows for the same state
+ *               and event, building its dispatch index at compile time has
+ *               to stop at the second one instead of letting it replace the
+ *               first. ctest builds this and expects the build to fail
+ *  Author: David Barbour
+ */
+
+#include <stddef.h>
+#include "StateMachine.h"
+
+enum { IDLE, RUNNING, STATES };
+enum { GO, STOP, EVENTS };
+
+void start() {}
+void stop() {}
+
+const MachineState states[STATES] = {
+  {NULL, NULL, NULL},
+  {NULL, NULL, NULL}
+};
+
+constexpr Transition transitions[] = {
+  {IDLE,    GO,   RUNNING, start},
+  {RUNNING, STOP, IDLE,    stop},
+  {IDLE,    GO,   IDLE,    NULL}
+};
+
+constexpr auto dispatch = buildDispatchIndex<STATES,EVENTS>(transitions);
+StateMachine<STATES,EVENTS> machine(states,transitions,dispatch);
+
+int main() {
+  machine.start(IDLE);
+  return machine.dispatch(GO) ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+/*
+ *  Project: DogBed
+ *  Description: Replays four hours of a noisy bed temperature that sits on
+ *               the cooling setpoint, with the dog getting on and off and the
+ *               bed leaving the running states now and then. The hysteresis
+ *               thermostat has to stay under its switch cap in every hour,
+ *               keep its minimum on and off times across a reset, counting
+ *               the off time from when the reset let the outlets go, and
+ *               switch less than the plain threshold thermostat
+ *  Author: David Barbour
+ */
+
+#include "HostTest.h"
+#include "ThermostatControl.h"
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+// the bed's settings, from DogBed.cpp
+const int32_t DEADBAND = 50;
+const unsigned int MIN_ON_TIME = 120000;
+const unsigned int MIN_OFF_TIME = 180000;
+const int MAX_COMMANDS = 6;
+const unsigned int COMMAND_WINDOW = 3600000;
+
+const unsigned int HOURS = 4;
+const unsigned int STEP = 1000;             // a sample a second, like the sensor
+
+int main() {
+  HysteresisControl hysteresis(DEADBAND,MIN_ON_TIME,MIN_OFF_TIME,MAX_COMMANDS,COMMAND_WINDOW);
+  ThresholdControl threshold;
+  ControlInput input;
+  ControlDecision decision;
+  ControlAction lastRun = ACTION_OFF;
+  std::vector<unsigned int> switches;
+  unsigned int changed = 0;                 // when the outlets last changed, a switch or a reset
+  unsigned int lastCommands = 0;
+  unsigned int onBedUntil = 0, offBedUntil = 0;
+
+  srand(1);
+  input.heatingTemp = 7000;
+  input.coolingTemp = 7400;
+  input.occupied = true;
+
+  for (unsigned int now=0; now < HOURS * 3600000; now += STEP) {
+    // 74F give or take 0.6F over 20 minutes, and 0.2F of sensor noise
+    input.temp = 7400 + (int32_t)(60 * sin(now * 2 * M_PI / 1200000.0)) + rand() % 41 - 20;
+    input.now = now;
+
+    // on the bed for a while, off for a while, about 70% on
+    if (now >= onBedUntil && now >= offBedUntil) {
+      if (input.occupied) {
+        input.occupied = false;
+        offBedUntil = now + (rand() % 600) * STEP;
+      }
+      else {
+        input.occupied = true;
+        onBedUntil = now + (rand() % 1400) * STEP;
+      }
+    }
+
+    // every half hour the bed spends a minute in setup, which resets the thermostat
+    if (now % 1800000 < 60000) {
+      hysteresis.reset(now);
+      threshold.reset(now);
+      // the bed switched off whatever was running, the off time starts here
+      if (lastRun != ACTION_OFF) {
+        changed = now;
+      }
+      lastRun = ACTION_OFF;
+      continue;
+    }
+
+    decision = hysteresis.decide(input);
+    threshold.decide(input);
+    if (hysteresis.commands() != lastCommands) {
+      lastCommands = hysteresis.commands();
+      // the outlets stay as they were for the minimum time
+      if (!switches.empty()) {
+        CHECK(now - changed >= ((lastRun == ACTION_OFF) ? MIN_OFF_TIME : MIN_ON_TIME));
+      }
+      switches.push_back(now);
+      changed = now;
+      lastRun = decision.run;
+    }
+  }
+
+  printf("%u hours, hysteresis switched %u times, threshold %u times\n",HOURS,hysteresis.commands(),threshold.commands());
+
+  // no more than the cap in any window
+  for (size_t i=MAX_COMMANDS; i<switches.size(); i++) {
+    CHECK(switches[i] - switches[i - MAX_COMMANDS] >= COMMAND_WINDOW);
+  }
+  CHECK(hysteresis.commands() <= HOURS * MAX_COMMANDS);
+  CHECK(hysteresis.commands() > 0);
+  CHECK(hysteresis.commands() < threshold.commands());
+
+  // a fan that ran long past its minimum, then a reset, stays off for the
+  // minimum off time from the reset and not from when it was switched on
+  HysteresisControl fan(DEADBAND,MIN_ON_TIME,MIN_OFF_TIME,MAX_COMMANDS,COMMAND_WINDOW);
+  input.temp = 7500;
+  input.occupied = true;
+  input.now = 0;
+  CHECK_EQUAL(ACTION_COOL,fan.decide(input).run);
+  fan.reset(1000000);
+  fan.reset(1001000);                       // called again on the next pass, still off since the first
+  input.now = 1000000 + MIN_OFF_TIME - STEP;
+  CHECK_EQUAL(ACTION_OFF,fan.decide(input).run);
+  input.now = 1000000 + MIN_OFF_TIME;
+  CHECK_EQUAL(ACTION_COOL,fan.decide(input).run);
+
+  return testResult();
+}
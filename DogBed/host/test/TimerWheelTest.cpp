@@ -0,0 +1,100 @@
+/*
+ *  Project: DogBed
+ *  Description: TimerWheel across the millis() wraparound. Timers armed a
+ *               few seconds before 0xFFFFFFFF have to fire in order and on
+ *               their tick after millis() starts again from 0, a cancelled
+ *               one must not fire, and a timer that re-arms itself from its
+ *               callback keeps its period across the wrap
+ *  Author: David Barbour
+ */
+
+#include "HostTest.h"
+#include "HostHal.h"
+#include "TimerWheel.h"
+#include <vector>
+
+const unsigned int START = 0xFFFFFFFF - 5000;
+const int CHAINED = 8;
+
+TimerWheel timers;
+
+// what fired, and when
+struct Fired {
+  char name;
+  unsigned int at;
+};
+std::vector<Fired> fired;
+int chained = 0;
+
+void fire(char name) {
+  Fired f = {name, millis()};
+  fired.push_back(f);
+}
+
+void timerA() { fire('A'); }
+void timerB() { fire('B'); }
+void timerC() { fire('C'); }
+void timerD() { fire('D'); }
+
+void timerE() {
+  fire('E');
+  if (++chained < CHAINED) {
+    timers.add(timerE,1000);
+  }
+}
+
+// the time from START to when the timer is due, wrapping like millis()
+unsigned int after(unsigned int ms) {
+  return START + ms;
+}
+
+int main() {
+  int idB;
+
+  hostHal::useFakeClock(START);
+  timers.begin();
+
+  timers.add(timerE,1000);
+  CHECK(timers.add(timerA,3500) >= 0);
+  idB = timers.add(timerB,6000);
+  CHECK(idB >= 0);
+  CHECK(timers.add(timerC,6500) >= 0);
+  CHECK(timers.add(timerD,700000) >= 0);
+  timers.cancel(idB);
+  CHECK(!timers.isRunning(idB));
+  CHECK_EQUAL(1000,timers.nextDeadline());
+
+  // up to just before the wrap
+  while (millis() != 0xFFFFFFFF) {
+    hostHal::advance(1);
+    timers.run();
+  }
+  // E just re-armed itself at 5 s, its next run is on the other side
+  CHECK_EQUAL(1000,timers.nextDeadline());
+  // across it and on past the long timer
+  while ((unsigned int)(millis() - START) < 700000) {
+    hostHal::advance(1);
+    timers.run();
+    if (millis() == 1500) {
+      // 6.5 s after START, E at 7 s is next
+      CHECK_EQUAL(after(7000) - 1500,timers.nextDeadline());
+    }
+  }
+  CHECK_EQUAL(0xFFFFFFFF,timers.nextDeadline());
+
+  // E every second, A at 3.5 s, C at 6.5 s, D at 700 s, B never
+  const Fired expected[] = {
+    {'E',after(1000)}, {'E',after(2000)}, {'E',after(3000)}, {'A',after(3500)},
+    {'E',after(4000)}, {'E',after(5000)}, {'E',after(6000)}, {'C',after(6500)},
+    {'E',after(7000)}, {'E',after(8000)}, {'D',after(700000)}
+  };
+  const size_t count = sizeof(expected) / sizeof(expected[0]);
+
+  CHECK_EQUAL(count,fired.size());
+  for (size_t i=0; i<count && i<fired.size(); i++) {
+    CHECK_EQUAL(expected[i].name,fired[i].name);
+    CHECK_EQUAL(expected[i].at,fired[i].at);
+  }
+
+  return testResult();
+}
@@ -0,0 +1,80 @@
+/*
+ *  Project: DogBed
+ *  Description: With the worker started, pump() hands the request over and
+ *               returns while a slow outlet is still connecting. The result
+ *               comes back through a later pump(), and writes made in the
+ *               meantime are queued behind it
+ *  Author: David Barbour
+ */
+
+#include "HostTest.h"
+#include "HostHal.h"
+#include "WemoQueue.h"
+
+const unsigned long CONNECT_MILLIS = 300;   // an outlet that is slow to answer
+
+WemoQueue outlets;
+
+int main() {
+  unsigned int start, longest = 0, took, loops = 0;
+
+  hostHal::network.connectMillis = CONNECT_MILLIS;
+  outlets.begin();
+
+  // two outlets, each a slow connect, and one of them asked twice
+  outlets.write(2,true);
+  outlets.write(4,true);
+  outlets.write(2,false);
+  CHECK_EQUAL(1,outlets.collapsedCount());
+
+  start = millis();
+  while (outlets.busy() && millis() - start < 5000) {
+    took = millis();
+    outlets.pump();
+    took = millis() - took;
+    if (took > longest) {
+      longest = took;
+    }
+    loops++;
+    delay(1);
+  }
+  printf("2 requests with %lu ms connects took %u ms, %u loops, longest pump() %u ms\n",
+    CONNECT_MILLIS,millis() - start,loops,longest);
+
+  CHECK(!outlets.busy());
+  CHECK_EQUAL(2,outlets.sentCount());
+  CHECK_EQUAL(0,outlets.failedCount());
+  CHECK_EQUAL(2,hostHal::network.connects);
+  // the loop kept going while the worker waited on the outlets
+  CHECK(longest < 20);
+  CHECK(loops > 100);
+
+  // a connection that is already open is reused, no connect to wait for
+  hostHal::network.connects = 0;
+  outlets.write(4,false);
+  while (outlets.busy()) {
+    outlets.pump();
+    delay(1);
+  }
+  CHECK_EQUAL(3,outlets.sentCount());
+  CHECK_EQUAL(0,hostHal::network.connects);
+
+  // an outlet that never answers is a failure, it doesn't hold up the loop either
+  hostHal::network.reachable = false;
+  outlets.write(3,true);
+  longest = 0;
+  while (outlets.busy()) {
+    took = millis();
+    outlets.pump();
+    took = millis() - took;
+    if (took > longest) {
+      longest = took;
+    }
+    delay(1);
+  }
+  CHECK_EQUAL(3,outlets.sentCount());
+  CHECK_EQUAL(1,outlets.failedCount());
+  CHECK(longest < 20);
+
+  return testResult();
+}
@@ -39,7 +39,7 @@
 */
 /**************************************************************************/
 Adafruit_BME280::Adafruit_BME280()
-    : _cs(-1), _mosi(-1), _miso(-1), _sck(-1)
+    : _cs(-1), _mosi(-1), _miso(-1), _sck(-1), _measuring(false), _measureStart(0)
 { }
 
 /**************************************************************************/
@@ -49,7 +49,7 @@ Adafruit_BME280::Adafruit_BME280()
 */
 /**************************************************************************/
 Adafruit_BME280::Adafruit_BME280(int8_t cspin)
-    : _cs(cspin), _mosi(-1), _miso(-1), _sck(-1)
+    : _cs(cspin), _mosi(-1), _miso(-1), _sck(-1), _measuring(false), _measureStart(0)
 { }
 
 /**************************************************************************/
@@ -62,7 +62,7 @@ Adafruit_BME280::Adafruit_BME280(int8_t cspin)
 */
 /**************************************************************************/
 Adafruit_BME280::Adafruit_BME280(int8_t cspin, int8_t mosipin, int8_t misopin, int8_t sckpin)
-    : _cs(cspin), _mosi(mosipin), _miso(misopin), _sck(sckpin)
+    : _cs(cspin), _mosi(mosipin), _miso(misopin), _sck(sckpin), _measuring(false), _measureStart(0)
 { }
 
 
@@ -413,9 +413,41 @@ uint32_t Adafruit_BME280::read24(byte reg)
 }
 
 
+/**************************************************************************/
+/*!
+    @brief  Reads a run of registers in one I2C or SPI transaction
+    @param reg the first register address to read from
+    @param buffer where the register values are stored
+    @param len the number of registers to read
+*/
+/**************************************************************************/
+void Adafruit_BME280::readBurst(byte reg, uint8_t *buffer, uint8_t len)
+{
+    if (_cs == -1) {
+        _wire -> beginTransmission((uint8_t)_i2caddr);
+        _wire -> write((uint8_t)reg);
+        _wire -> endTransmission();
+        _wire -> requestFrom((uint8_t)_i2caddr, (byte)len);
+        for (uint8_t i = 0; i < len; i++)
+            buffer[i] = _wire -> read();
+    } else {
+        if (_sck == -1)
+            SPI.beginTransaction(SPISettings(500000, MSBFIRST, SPI_MODE0));
+        digitalWrite(_cs, LOW);
+        spixfer(reg | 0x80); // read, bit 7 high, the address auto increments
+        for (uint8_t i = 0; i < len; i++)
+            buffer[i] = spixfer(0);
+        digitalWrite(_cs, HIGH);
+        if (_sck == -1)
+            SPI.endTransaction(); // release the SPI bus
+    }
+}
+
+
 /**************************************************************************/
 /*!
     @brief  Take a new measurement (only possible in forced mode)
+            and wait for it to finish
 */
 /**************************************************************************/
 void Adafruit_BME280::takeForcedMeasurement()
@@ -424,12 +456,12 @@ void Adafruit_BME280::takeForcedMeasurement()
     // measurement and we need to set it to forced mode once at this point, so
     // it will take the next measurement and then return to sleep again.
     // In normal mode simply does new measurements periodically.
-    if (_measReg.mode == MODE_FORCED) {
-        // set to forced mode, i.e. "take next measurement"
-        write8(BME280_REGISTER_CONTROL, _measReg.get());
-        // wait until measurement has been completed, otherwise we would read
-        // the values from the last measurement
-        while (read8(BME280_REGISTER_STATUS) & 0x08)
+    if (startForcedMeasurement()) {
+        // sleep through the conversion, then wait out anything left over,
+        // otherwise we would read the values from the last measurement.
+        // delay() lets other threads run, delayMicroseconds() would spin
+        delay((measurementTime() + 999) / 1000);
+        while (!measurementReady())
 		delay(1);
     }
 }
@@ -437,31 +469,119 @@ void Adafruit_BME280::takeForcedMeasurement()
 
 /**************************************************************************/
 /*!
-    @brief  Reads the factory-set coefficients
+    @brief  Start a forced measurement and return right away, use
+            measurementReady() and fetch() to pick up the result
+    @returns true if a measurement was started, false if the sensor is
+             not in forced mode
 */
 /**************************************************************************/
-void Adafruit_BME280::readCoefficients(void)
+bool Adafruit_BME280::startForcedMeasurement(void)
 {
-    _bme280_calib.dig_T1 = read16_LE(BME280_REGISTER_DIG_T1);
-    _bme280_calib.dig_T2 = readS16_LE(BME280_REGISTER_DIG_T2);
-    _bme280_calib.dig_T3 = readS16_LE(BME280_REGISTER_DIG_T3);
+    if (_measReg.mode != MODE_FORCED)
+        return false;
+
+    // set to forced mode, i.e. "take next measurement"
+    write8(BME280_REGISTER_CONTROL, _measReg.get());
+    _measureStart = micros();
+    _measuring = true;
+    return true;
+}
 
-    _bme280_calib.dig_P1 = read16_LE(BME280_REGISTER_DIG_P1);
-    _bme280_calib.dig_P2 = readS16_LE(BME280_REGISTER_DIG_P2);
-    _bme280_calib.dig_P3 = readS16_LE(BME280_REGISTER_DIG_P3);
-    _bme280_calib.dig_P4 = readS16_LE(BME280_REGISTER_DIG_P4);
-    _bme280_calib.dig_P5 = readS16_LE(BME280_REGISTER_DIG_P5);
-    _bme280_calib.dig_P6 = readS16_LE(BME280_REGISTER_DIG_P6);
-    _bme280_calib.dig_P7 = readS16_LE(BME280_REGISTER_DIG_P7);
-    _bme280_calib.dig_P8 = readS16_LE(BME280_REGISTER_DIG_P8);
-    _bme280_calib.dig_P9 = readS16_LE(BME280_REGISTER_DIG_P9);
 
-    _bme280_calib.dig_H1 = read8(BME280_REGISTER_DIG_H1);
-    _bme280_calib.dig_H2 = readS16_LE(BME280_REGISTER_DIG_H2);
-    _bme280_calib.dig_H3 = read8(BME280_REGISTER_DIG_H3);
-    _bme280_calib.dig_H4 = (read8(BME280_REGISTER_DIG_H4) << 4) | (read8(BME280_REGISTER_DIG_H4+1) & 0xF);
-    _bme280_calib.dig_H5 = (read8(BME280_REGISTER_DIG_H5+1) << 4) | (read8(BME280_REGISTER_DIG_H5) >> 4);
-    _bme280_calib.dig_H6 = (int8_t)read8(BME280_REGISTER_DIG_H6);
+/**************************************************************************/
+/*!
+    @brief  Check if the forced measurement has finished. The bus is not
+            touched until measurementTime() has gone by, after that the
+            status register is read once per call.
+    @returns true when a new measurement can be fetched
+*/
+/**************************************************************************/
+bool Adafruit_BME280::measurementReady(void)
+{
+    if (!_measuring)
+        return false;
+    if (micros() - _measureStart < measurementTime())
+        return false;
+    // the measuring bit is set while a conversion is running
+    if (read8(BME280_REGISTER_STATUS) & 0x08)
+        return false;
+
+    _measuring = false;
+    return true;
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Read the result of the last measurement
+    @returns the compensated measurement, see readAll()
+*/
+/**************************************************************************/
+Adafruit_BME280::Measurement Adafruit_BME280::fetch(void)
+{
+    return readAll();
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  The longest a measurement can take with the current
+            oversampling settings (DS 9.1)
+    @returns the measurement time in microseconds
+*/
+/**************************************************************************/
+uint32_t Adafruit_BME280::measurementTime(void)
+{
+    // oversampling register setting -> number of samples, 101 and above is x16
+    static const uint8_t samples[8] = { 0, 1, 2, 4, 8, 16, 16, 16 };
+    uint32_t t = 1250;
+
+    t += 2300 * samples[_measReg.osrs_t];
+    if (_measReg.osrs_p)
+        t += 2300 * samples[_measReg.osrs_p] + 575;
+    if (_humReg.osrs_h)
+        t += 2300 * samples[_humReg.osrs_h] + 575;
+    return t;
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Reads the factory-set coefficients
+*/
+/**************************************************************************/
+void Adafruit_BME280::readCoefficients(void)
+{
+    // the coefficients are in two blocks, each is read in one go and
+    // picked apart here (little endian, see DS table 16)
+    uint8_t tp[BME280_CALIB_TP_LENGTH];
+    uint8_t h[BME280_CALIB_H_LENGTH];
+
+    readBurst(BME280_REGISTER_DIG_T1, tp, BME280_CALIB_TP_LENGTH);
+    readBurst(BME280_REGISTER_DIG_H2, h, BME280_CALIB_H_LENGTH);
+
+    _bme280_calib.dig_T1 = (uint16_t)((tp[1] << 8) | tp[0]);
+    _bme280_calib.dig_T2 = (int16_t)((tp[3] << 8) | tp[2]);
+    _bme280_calib.dig_T3 = (int16_t)((tp[5] << 8) | tp[4]);
+
+    _bme280_calib.dig_P1 = (uint16_t)((tp[7] << 8) | tp[6]);
+    _bme280_calib.dig_P2 = (int16_t)((tp[9] << 8) | tp[8]);
+    _bme280_calib.dig_P3 = (int16_t)((tp[11] << 8) | tp[10]);
+    _bme280_calib.dig_P4 = (int16_t)((tp[13] << 8) | tp[12]);
+    _bme280_calib.dig_P5 = (int16_t)((tp[15] << 8) | tp[14]);
+    _bme280_calib.dig_P6 = (int16_t)((tp[17] << 8) | tp[16]);
+    _bme280_calib.dig_P7 = (int16_t)((tp[19] << 8) | tp[18]);
+    _bme280_calib.dig_P8 = (int16_t)((tp[21] << 8) | tp[20]);
+    _bme280_calib.dig_P9 = (int16_t)((tp[23] << 8) | tp[22]);
+
+    // tp[24] (0xA0) is not used
+    _bme280_calib.dig_H1 = tp[25];
+    _bme280_calib.dig_H2 = (int16_t)((h[1] << 8) | h[0]);
+    _bme280_calib.dig_H3 = h[2];
+    // H4 and H5 are 12 bits each and share the nibbles of 0xE5
+    _bme280_calib.dig_H4 = (h[3] << 4) | (h[4] & 0xF);
+    _bme280_calib.dig_H5 = (h[5] << 4) | (h[4] >> 4);
+    _bme280_calib.dig_H6 = (int8_t)h[6];
 }
 
 /**************************************************************************/
@@ -485,12 +605,72 @@ bool Adafruit_BME280::isReadingCalibration(void)
 */
 /**************************************************************************/
 float Adafruit_BME280::readTemperature(void)
+{
+    return compensateTemperature(read24(BME280_REGISTER_TEMPDATA));
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Returns the temperature from the sensor without any floating
+            point, straight from t_fine
+    @returns the temperature in 1/100 degrees C, e.g. 2345 is 23.45 C
+*/
+/**************************************************************************/
+int32_t Adafruit_BME280::readTemperatureCenti(void)
+{
+    return compensateTemperatureCenti(read24(BME280_REGISTER_TEMPDATA));
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Converts 1/100 degrees C to 1/100 degrees F in integer math,
+            rounded to the nearest
+    @param centiC the temperature in 1/100 degrees C
+    @returns the temperature in 1/100 degrees F
+*/
+/**************************************************************************/
+int32_t Adafruit_BME280::centiCelsiusToFahrenheit(int32_t centiC)
+{
+    if (centiC == TEMPERATURE_INVALID)
+        return TEMPERATURE_INVALID;
+
+    int32_t scaled = centiC * 9;
+    return (scaled >= 0 ? scaled + 2 : scaled - 2) / 5 + 3200;
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Turns a raw temperature reading into degrees C and updates t_fine
+    @param adc_T the 20 bit temperature reading as read from 0xFA-0xFC
+    @returns the temperature in degrees C
+*/
+/**************************************************************************/
+float Adafruit_BME280::compensateTemperature(int32_t adc_T)
+{
+    int32_t T = compensateTemperatureCenti(adc_T);
+    if (T == TEMPERATURE_INVALID)
+        return NAN;
+    return (float)T/100;
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Turns a raw temperature reading into 1/100 degrees C and
+            updates t_fine (DS 4.2.3)
+    @param adc_T the 20 bit temperature reading as read from 0xFA-0xFC
+    @returns the temperature in 1/100 degrees C
+*/
+/**************************************************************************/
+int32_t Adafruit_BME280::compensateTemperatureCenti(int32_t adc_T)
 {
     int32_t var1, var2;
 
-    int32_t adc_T = read24(BME280_REGISTER_TEMPDATA);
     if (adc_T == 0x800000) // value in case temp measurement was disabled
-        return NAN;
+        return TEMPERATURE_INVALID;
     adc_T >>= 4;
 
     var1 = ((((adc_T>>3) - ((int32_t)_bme280_calib.dig_T1 <<1))) *
@@ -502,8 +682,7 @@ float Adafruit_BME280::readTemperature(void)
 
     t_fine = var1 + var2;
 
-    float T = (t_fine * 5 + 128) >> 8;
-    return T/100;
+    return (t_fine * 5 + 128) >> 8;
 }
 
 
@@ -514,11 +693,23 @@ float Adafruit_BME280::readTemperature(void)
 */
 /**************************************************************************/
 float Adafruit_BME280::readPressure(void) {
-    int64_t var1, var2, p;
-
     readTemperature(); // must be done first to get t_fine
 
-    int32_t adc_P = read24(BME280_REGISTER_PRESSUREDATA);
+    return compensatePressure(read24(BME280_REGISTER_PRESSUREDATA));
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Turns a raw pressure reading into Pascal, t_fine has to be
+            up to date for the same sample
+    @param adc_P the 20 bit pressure reading as read from 0xF7-0xF9
+    @returns the pressure in Pascal
+*/
+/**************************************************************************/
+float Adafruit_BME280::compensatePressure(int32_t adc_P) {
+    int64_t var1, var2, p;
+
     if (adc_P == 0x800000) // value in case pressure measurement was disabled
         return NAN;
     adc_P >>= 4;
@@ -553,7 +744,19 @@ float Adafruit_BME280::readPressure(void) {
 float Adafruit_BME280::readHumidity(void) {
     readTemperature(); // must be done first to get t_fine
 
-    int32_t adc_H = read16(BME280_REGISTER_HUMIDDATA);
+    return compensateHumidity(read16(BME280_REGISTER_HUMIDDATA));
+}
+
+
+/**************************************************************************/
+/*!
+    @brief  Turns a raw humidity reading into %RH, t_fine has to be
+            up to date for the same sample
+    @param adc_H the 16 bit humidity reading as read from 0xFD-0xFE
+    @returns the relative humidity in %
+*/
+/**************************************************************************/
+float Adafruit_BME280::compensateHumidity(int32_t adc_H) {
     if (adc_H == 0x8000) // value in case humidity measurement was disabled
         return NAN;
         
@@ -577,6 +780,30 @@ float Adafruit_BME280::readHumidity(void) {
 }
 
 
+/**************************************************************************/
+/*!
+    @brief  Reads temperature, pressure and humidity in one burst, so all
+            three come from the same conversion and t_fine is only worked
+            out once
+    @returns the compensated measurement
+*/
+/**************************************************************************/
+Adafruit_BME280::Measurement Adafruit_BME280::readAll(void)
+{
+    uint8_t data[BME280_MEASUREMENT_LENGTH];
+    Measurement m;
+
+    readBurst(BME280_REGISTER_PRESSUREDATA, data, BME280_MEASUREMENT_LENGTH);
+
+    // temperature first, pressure and humidity need its t_fine
+    m.temperatureCenti = compensateTemperatureCenti(((uint32_t)data[3] << 16) | ((uint32_t)data[4] << 8) | data[5]);
+    m.temperature = (m.temperatureCenti == TEMPERATURE_INVALID) ? NAN : (float)m.temperatureCenti/100;
+    m.pressure = compensatePressure(((uint32_t)data[0] << 16) | ((uint32_t)data[1] << 8) | data[2]);
+    m.humidity = compensateHumidity(((uint32_t)data[6] << 8) | data[7]);
+    return m;
+}
+
+
 /**************************************************************************/
 /*!
     Calculates the altitude (in meters) from the specified atmospheric
@@ -199,6 +199,22 @@ class Adafruit_BME280 {
             STANDBY_MS_1000 = 0b101
         };
     
+        /**************************************************************************/
+        /*! 
+            @brief  one temperature, pressure and humidity sample, all from the
+                    same conversion
+        */
+        /**************************************************************************/
+        struct Measurement {
+            int32_t temperatureCenti; ///< 1/100 degrees C, TEMPERATURE_INVALID if temperature is skipped
+            float temperature; ///< degrees C, NAN if temperature is skipped
+            float pressure;    ///< Pascal, NAN if pressure is skipped
+            float humidity;    ///< %RH, NAN if humidity is skipped
+        };
+
+        /// returned by the centi degree calls when temperature is skipped
+        static const int32_t TEMPERATURE_INVALID = INT32_MIN;
+
         // constructors
         Adafruit_BME280(void);
         Adafruit_BME280(int8_t cspin);
@@ -219,9 +235,16 @@ class Adafruit_BME280 {
 			 );
                    
         void takeForcedMeasurement();
+        bool startForcedMeasurement(void);
+        bool measurementReady(void);
+        Measurement fetch(void);
+        uint32_t measurementTime(void);
         float readTemperature(void);
+        int32_t readTemperatureCenti(void);
+        static int32_t centiCelsiusToFahrenheit(int32_t centiC);
         float readPressure(void);
         float readHumidity(void);
+        Measurement readAll(void);
         
         float readAltitude(float seaLevel);
         float seaLevelForAltitude(float altitude, float pressure);
@@ -240,6 +263,17 @@ class Adafruit_BME280 {
         int16_t   readS16(byte reg);
         uint16_t  read16_LE(byte reg); // little endian
         int16_t   readS16_LE(byte reg); // little endian
+        void      readBurst(byte reg, uint8_t *buffer, uint8_t len);
+
+        // burst lengths for readBurst()
+        static const uint8_t BME280_MEASUREMENT_LENGTH = 8;   //!< pressure, temperature and humidity, 0xF7-0xFE
+        static const uint8_t BME280_CALIB_TP_LENGTH    = 26;  //!< dig_T1 to dig_P9 and dig_H1, 0x88-0xA1
+        static const uint8_t BME280_CALIB_H_LENGTH     = 7;   //!< dig_H2 to dig_H6, 0xE1-0xE7
+
+        float     compensateTemperature(int32_t adc_T);
+        int32_t   compensateTemperatureCenti(int32_t adc_T);
+        float     compensatePressure(int32_t adc_P);
+        float     compensateHumidity(int32_t adc_H);
 
         uint8_t   _i2caddr; //!< I2C addr for the TwoWire interface
         int32_t   _sensorID; //!< ID of the BME Sensor
@@ -250,6 +284,9 @@ class Adafruit_BME280 {
         int8_t _miso; //!< for the SPI interface
         int8_t _sck;  //!< for the SPI interface
 
+        bool     _measuring; //!< a forced measurement has been started and not yet seen finished
+        uint32_t _measureStart; //!< micros() when the forced measurement was started
+
         bme280_calib_data _bme280_calib; //!< here calibration data is stored
 
 
@@ -90,6 +90,13 @@ static uint8_t buffer[SSD1306_LCDHEIGHT * SSD1306_LCDWIDTH / 8] = {
 #endif
 };
 
+// what the flush thread is sending, only used after beginAsync()
+static uint8_t frontBuffer[SSD1306_LCDHEIGHT * SSD1306_LCDWIDTH / 8];
+
+// the window being sent by DMA in one piece, and who is sending it
+static uint8_t spiBuffer[SSD1306_LCDHEIGHT * SSD1306_LCDWIDTH / 8];
+static Adafruit_SSD1306 *dmaDisplay = NULL;
+
 
 
 // the most basic function, set a single pixel
@@ -113,6 +120,8 @@ void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
     break;
   }  
 
+  markDirty(x, x, y, y);
+
   // x is which column
   if (color == WHITE) 
     buffer[x+ (y/8)*SSD1306_LCDWIDTH] |= (1 << (y&7));  
@@ -128,6 +137,13 @@ Adafruit_SSD1306::Adafruit_SSD1306(int8_t SID, int8_t SCLK, int8_t DC, int8_t RS
   sclk = SCLK;
   sid = SID;
   hwSPI = false;
+  _bytesSaved = _busBytes = _busTransactions = 0;
+  _flushThread = NULL;
+  _flushing = _held = false;
+  _dma = false;
+  _dmaBusy = false;
+  _coalesced = 0;
+  invalidate();
 }
 
 // constructor for hardware SPI - we indicate DataCommand, ChipSelect, Reset 
@@ -135,7 +151,15 @@ Adafruit_SSD1306::Adafruit_SSD1306(int8_t DC, int8_t RST, int8_t CS) : Adafruit_
   dc = DC;
   rst = RST;
   cs = CS;
+  sclk = sid = -1;
   hwSPI = true;
+  _bytesSaved = _busBytes = _busTransactions = 0;
+  _flushThread = NULL;
+  _flushing = _held = false;
+  _dma = false;
+  _dmaBusy = false;
+  _coalesced = 0;
+  invalidate();
 }
 
 // initializer for I2C - we only indicate the reset pin!
@@ -143,6 +167,14 @@ Adafruit_SSD1306::Adafruit_SSD1306(int8_t reset) :
 Adafruit_GFX(SSD1306_LCDWIDTH, SSD1306_LCDHEIGHT) {
   sclk = dc = cs = sid = -1;
   rst = reset;
+  hwSPI = false;
+  _bytesSaved = _busBytes = _busTransactions = 0;
+  _flushThread = NULL;
+  _flushing = _held = false;
+  _dma = false;
+  _dmaBusy = false;
+  _coalesced = 0;
+  invalidate();
 }
   
 
@@ -151,7 +183,7 @@ void Adafruit_SSD1306::begin(uint8_t vccstate, uint8_t i2caddr) {
   _i2caddr = i2caddr;
 
   // set pin directions
-  if (sid != -1){
+  if (isSPI()){
     pinMode(dc, OUTPUT);
     pinMode(cs, OUTPUT);
     if (!hwSPI){
@@ -186,78 +218,59 @@ void Adafruit_SSD1306::begin(uint8_t vccstate, uint8_t i2caddr) {
   digitalWrite(rst, HIGH);
   // turn on VCC (9V?)
 
-   #if defined SSD1306_128_32
+  // the whole init goes out as one command list, one transaction on I2C
+  bool external = (vccstate == SSD1306_EXTERNALVCC);
+
+  #if defined SSD1306_128_32
     // Init sequence for 128x32 OLED module
-    ssd1306_command(SSD1306_DISPLAYOFF);                    // 0xAE
-    ssd1306_command(SSD1306_SETDISPLAYCLOCKDIV);            // 0xD5
-    ssd1306_command(0x80);                                  // the suggested ratio 0x80
-    ssd1306_command(SSD1306_SETMULTIPLEX);                  // 0xA8
-    ssd1306_command(0x1F);
-    ssd1306_command(SSD1306_SETDISPLAYOFFSET);              // 0xD3
-    ssd1306_command(0x0);                                   // no offset
-    ssd1306_command(SSD1306_SETSTARTLINE | 0x0);            // line #0
-    ssd1306_command(SSD1306_CHARGEPUMP);                    // 0x8D
-    if (vccstate == SSD1306_EXTERNALVCC) 
-      { ssd1306_command(0x10); }
-    else 
-      { ssd1306_command(0x14); }
-    ssd1306_command(SSD1306_MEMORYMODE);                    // 0x20
-    ssd1306_command(0x00);                                  // 0x0 act like ks0108
-	ssd1306_command(SSD1306_SEGREMAP | 0x1);
-    ssd1306_command(SSD1306_COMSCANDEC);
-    ssd1306_command(SSD1306_SETCOMPINS);                    // 0xDA
-    ssd1306_command(0x02);
-    ssd1306_command(SSD1306_SETCONTRAST);                   // 0x81
-    ssd1306_command(0x8F);
-    ssd1306_command(SSD1306_SETPRECHARGE);                  // 0xd9
-    if (vccstate == SSD1306_EXTERNALVCC) 
-      { ssd1306_command(0x22); }
-    else 
-      { ssd1306_command(0xF1); }
-    ssd1306_command(SSD1306_SETVCOMDETECT);                 // 0xDB
-    ssd1306_command(0x40);
-    ssd1306_command(SSD1306_DISPLAYALLON_RESUME);           // 0xA4
-    ssd1306_command(SSD1306_NORMALDISPLAY);                 // 0xA6
+    const uint8_t init[] = {
+      SSD1306_DISPLAYOFF,                     // 0xAE
+      SSD1306_SETDISPLAYCLOCKDIV, 0x80,       // 0xD5, the suggested ratio 0x80
+      SSD1306_SETMULTIPLEX, 0x1F,             // 0xA8
+      SSD1306_SETDISPLAYOFFSET, 0x0,          // 0xD3, no offset
+      SSD1306_SETSTARTLINE | 0x0,             // line #0
+      SSD1306_CHARGEPUMP,                     // 0x8D
+      (uint8_t)(external ? 0x10 : 0x14),
+      SSD1306_MEMORYMODE, 0x00,               // 0x20, 0x0 act like ks0108
+      SSD1306_SEGREMAP | 0x1,
+      SSD1306_COMSCANDEC,
+      SSD1306_SETCOMPINS, 0x02,               // 0xDA
+      SSD1306_SETCONTRAST, 0x8F,              // 0x81
+      SSD1306_SETPRECHARGE,                   // 0xd9
+      (uint8_t)(external ? 0x22 : 0xF1),
+      SSD1306_SETVCOMDETECT, 0x40,            // 0xDB
+      SSD1306_DISPLAYALLON_RESUME,            // 0xA4
+      SSD1306_NORMALDISPLAY,                  // 0xA6
+      SSD1306_DISPLAYON                       //--turn on oled panel
+    };
   #endif
 
   #if defined SSD1306_128_64
     // Init sequence for 128x64 OLED module
-    ssd1306_command(SSD1306_DISPLAYOFF);                    // 0xAE
-    ssd1306_command(SSD1306_SETDISPLAYCLOCKDIV);            // 0xD5
-    ssd1306_command(0x80);                                  // the suggested ratio 0x80
-    ssd1306_command(SSD1306_SETMULTIPLEX);                  // 0xA8
-    ssd1306_command(0x3F);
-    ssd1306_command(SSD1306_SETDISPLAYOFFSET);              // 0xD3
-    ssd1306_command(0x0);                                   // no offset
-    ssd1306_command(SSD1306_SETSTARTLINE | 0x0);            // line #0
-    ssd1306_command(SSD1306_CHARGEPUMP);                    // 0x8D
-    if (vccstate == SSD1306_EXTERNALVCC) 
-      { ssd1306_command(0x10); }
-    else 
-      { ssd1306_command(0x14); }
-    ssd1306_command(SSD1306_MEMORYMODE);                    // 0x20
-    ssd1306_command(0x00);                                  // 0x0 act like ks0108
-    ssd1306_command(SSD1306_SEGREMAP | 0x1);
-    ssd1306_command(SSD1306_COMSCANDEC);
-    ssd1306_command(SSD1306_SETCOMPINS);                    // 0xDA
-    ssd1306_command(0x12);
-    ssd1306_command(SSD1306_SETCONTRAST);                   // 0x81
-    if (vccstate == SSD1306_EXTERNALVCC) 
-      { ssd1306_command(0x9F); }
-    else 
-      { ssd1306_command(0xCF); }
-    ssd1306_command(SSD1306_SETPRECHARGE);                  // 0xd9
-    if (vccstate == SSD1306_EXTERNALVCC) 
-      { ssd1306_command(0x22); }
-    else 
-      { ssd1306_command(0xF1); }
-    ssd1306_command(SSD1306_SETVCOMDETECT);                 // 0xDB
-    ssd1306_command(0x40);
-    ssd1306_command(SSD1306_DISPLAYALLON_RESUME);           // 0xA4
-    ssd1306_command(SSD1306_NORMALDISPLAY);                 // 0xA6
+    const uint8_t init[] = {
+      SSD1306_DISPLAYOFF,                     // 0xAE
+      SSD1306_SETDISPLAYCLOCKDIV, 0x80,       // 0xD5, the suggested ratio 0x80
+      SSD1306_SETMULTIPLEX, 0x3F,             // 0xA8
+      SSD1306_SETDISPLAYOFFSET, 0x0,          // 0xD3, no offset
+      SSD1306_SETSTARTLINE | 0x0,             // line #0
+      SSD1306_CHARGEPUMP,                     // 0x8D
+      (uint8_t)(external ? 0x10 : 0x14),
+      SSD1306_MEMORYMODE, 0x00,               // 0x20, 0x0 act like ks0108
+      SSD1306_SEGREMAP | 0x1,
+      SSD1306_COMSCANDEC,
+      SSD1306_SETCOMPINS, 0x12,               // 0xDA
+      SSD1306_SETCONTRAST,                    // 0x81
+      (uint8_t)(external ? 0x9F : 0xCF),
+      SSD1306_SETPRECHARGE,                   // 0xd9
+      (uint8_t)(external ? 0x22 : 0xF1),
+      SSD1306_SETVCOMDETECT, 0x40,            // 0xDB
+      SSD1306_DISPLAYALLON_RESUME,            // 0xA4
+      SSD1306_NORMALDISPLAY,                  // 0xA6
+      SSD1306_DISPLAYON                       //--turn on oled panel
+    };
   #endif
-  
-  ssd1306_command(SSD1306_DISPLAYON);//--turn on oled panel
+
+  ssd1306_commandList(init, sizeof(init));
 }
 
 
@@ -270,23 +283,68 @@ void Adafruit_SSD1306::invertDisplay(uint8_t i) {
 }
 
 void Adafruit_SSD1306::ssd1306_command(uint8_t c) { 
-  if (sid != -1)
+  if (isSPI())
   {
     // SPI
+    waitForDMA();
     digitalWrite(cs, HIGH);
     digitalWrite(dc, LOW);
     digitalWrite(cs, LOW);
     fastSPIwrite(c);
     digitalWrite(cs, HIGH);
+    _busBytes += 1;
+    _busTransactions++;
   }
   else
   {
     // I2C
     uint8_t control = 0x00;   // Co = 0, D/C = 0
-    Wire.beginTransmission(_i2caddr);
-    Wire.write(control);
-    Wire.write(c);
-    Wire.endTransmission();
+    WITH_LOCK(Wire) {
+      Wire.beginTransmission(_i2caddr);
+      Wire.write(control);
+      Wire.write(c);
+      Wire.endTransmission();
+    }
+    _busBytes += 3;           // address, control, command
+    _busTransactions++;
+  }
+}
+
+// send a run of command bytes (and their arguments) together: on SPI with CS
+// held low once, on I2C behind one control byte, as few transmissions as
+// the Wire buffer allows
+void Adafruit_SSD1306::ssd1306_commandList(const uint8_t *c, uint8_t n) {
+  if (isSPI())
+  {
+    // SPI
+    waitForDMA();
+    digitalWrite(cs, HIGH);
+    digitalWrite(dc, LOW);
+    digitalWrite(cs, LOW);
+    for (uint8_t i=0; i<n; i++) {
+      fastSPIwrite(c[i]);
+    }
+    digitalWrite(cs, HIGH);
+    _busBytes += n;
+    _busTransactions++;
+  }
+  else
+  {
+    // I2C
+    uint8_t control = 0x00;   // Co = 0, D/C = 0, every byte after this is a command
+    while (n) {
+      uint8_t chunk = (n > SSD1306_I2C_COMMANDS) ? SSD1306_I2C_COMMANDS : n;
+      WITH_LOCK(Wire) {
+        Wire.beginTransmission(_i2caddr);
+        Wire.write(control);
+        Wire.write(c, chunk);
+        Wire.endTransmission();
+      }
+      _busBytes += 2 + chunk; // address, control, commands
+      _busTransactions++;
+      c += chunk;
+      n -= chunk;
+    }
   }
 }
 
@@ -295,14 +353,9 @@ void Adafruit_SSD1306::ssd1306_command(uint8_t c) {
 // Hint, the display is 16 rows tall. To scroll the whole display, run:
 // display.scrollright(0x00, 0x0F) 
 void Adafruit_SSD1306::startscrollright(uint8_t start, uint8_t stop){
-	ssd1306_command(SSD1306_RIGHT_HORIZONTAL_SCROLL);
-	ssd1306_command(0X00);
-	ssd1306_command(start);
-	ssd1306_command(0X00);
-	ssd1306_command(stop);
-	ssd1306_command(0X00);
-	ssd1306_command(0XFF);
-	ssd1306_command(SSD1306_ACTIVATE_SCROLL);
+	const uint8_t cmds[] = {SSD1306_RIGHT_HORIZONTAL_SCROLL, 0X00, start, 0X00, stop, 0X00, 0XFF,
+		SSD1306_ACTIVATE_SCROLL};
+	ssd1306_commandList(cmds, sizeof(cmds));
 }
 
 // startscrollleft
@@ -310,14 +363,9 @@ void Adafruit_SSD1306::startscrollright(uint8_t start, uint8_t stop){
 // Hint, the display is 16 rows tall. To scroll the whole display, run:
 // display.scrollright(0x00, 0x0F) 
 void Adafruit_SSD1306::startscrollleft(uint8_t start, uint8_t stop){
-	ssd1306_command(SSD1306_LEFT_HORIZONTAL_SCROLL);
-	ssd1306_command(0X00);
-	ssd1306_command(start);
-	ssd1306_command(0X00);
-	ssd1306_command(stop);
-	ssd1306_command(0X00);
-	ssd1306_command(0XFF);
-	ssd1306_command(SSD1306_ACTIVATE_SCROLL);
+	const uint8_t cmds[] = {SSD1306_LEFT_HORIZONTAL_SCROLL, 0X00, start, 0X00, stop, 0X00, 0XFF,
+		SSD1306_ACTIVATE_SCROLL};
+	ssd1306_commandList(cmds, sizeof(cmds));
 }
 
 // startscrolldiagright
@@ -325,16 +373,10 @@ void Adafruit_SSD1306::startscrollleft(uint8_t start, uint8_t stop){
 // Hint, the display is 16 rows tall. To scroll the whole display, run:
 // display.scrollright(0x00, 0x0F) 
 void Adafruit_SSD1306::startscrolldiagright(uint8_t start, uint8_t stop){
-	ssd1306_command(SSD1306_SET_VERTICAL_SCROLL_AREA);	
-	ssd1306_command(0X00);
-	ssd1306_command(SSD1306_LCDHEIGHT);
-	ssd1306_command(SSD1306_VERTICAL_AND_RIGHT_HORIZONTAL_SCROLL);
-	ssd1306_command(0X00);
-	ssd1306_command(start);
-	ssd1306_command(0X00);
-	ssd1306_command(stop);
-	ssd1306_command(0X01);
-	ssd1306_command(SSD1306_ACTIVATE_SCROLL);
+	const uint8_t cmds[] = {SSD1306_SET_VERTICAL_SCROLL_AREA, 0X00, SSD1306_LCDHEIGHT,
+		SSD1306_VERTICAL_AND_RIGHT_HORIZONTAL_SCROLL, 0X00, start, 0X00, stop, 0X01,
+		SSD1306_ACTIVATE_SCROLL};
+	ssd1306_commandList(cmds, sizeof(cmds));
 }
 
 // startscrolldiagleft
@@ -342,16 +384,10 @@ void Adafruit_SSD1306::startscrolldiagright(uint8_t start, uint8_t stop){
 // Hint, the display is 16 rows tall. To scroll the whole display, run:
 // display.scrollright(0x00, 0x0F) 
 void Adafruit_SSD1306::startscrolldiagleft(uint8_t start, uint8_t stop){
-	ssd1306_command(SSD1306_SET_VERTICAL_SCROLL_AREA);	
-	ssd1306_command(0X00);
-	ssd1306_command(SSD1306_LCDHEIGHT);
-	ssd1306_command(SSD1306_VERTICAL_AND_LEFT_HORIZONTAL_SCROLL);
-	ssd1306_command(0X00);
-	ssd1306_command(start);
-	ssd1306_command(0X00);
-	ssd1306_command(stop);
-	ssd1306_command(0X01);
-	ssd1306_command(SSD1306_ACTIVATE_SCROLL);
+	const uint8_t cmds[] = {SSD1306_SET_VERTICAL_SCROLL_AREA, 0X00, SSD1306_LCDHEIGHT,
+		SSD1306_VERTICAL_AND_LEFT_HORIZONTAL_SCROLL, 0X00, start, 0X00, stop, 0X01,
+		SSD1306_ACTIVATE_SCROLL};
+	ssd1306_commandList(cmds, sizeof(cmds));
 }
 
 void Adafruit_SSD1306::stopscroll(void){
@@ -375,41 +411,110 @@ void Adafruit_SSD1306::dim(bool dim) {
   }
   // the range of contrast to too small to be really useful
   // it is useful to dim the display
-  ssd1306_command(SSD1306_SETCONTRAST);
-  ssd1306_command(contrast);
+  const uint8_t cmds[] = {SSD1306_SETCONTRAST, contrast};
+  ssd1306_commandList(cmds, sizeof(cmds));
 }
 
 void Adafruit_SSD1306::ssd1306_data(uint8_t c) {
-  if (sid != -1)
+  if (isSPI())
   {
     // SPI
+    waitForDMA();
     digitalWrite(cs, HIGH);
     digitalWrite(dc, HIGH);
     digitalWrite(cs, LOW);
     fastSPIwrite(c);
     digitalWrite(cs, HIGH);
+    _busBytes += 1;
+    _busTransactions++;
   }
   else
   {
     // I2C
     uint8_t control = 0x40;   // Co = 0, D/C = 1
-    Wire.beginTransmission(_i2caddr);
-    Wire.write(control);
-    Wire.write(c);
-    Wire.endTransmission();
+    WITH_LOCK(Wire) {
+      Wire.beginTransmission(_i2caddr);
+      Wire.write(control);
+      Wire.write(c);
+      Wire.endTransmission();
+    }
+    _busBytes += 3;           // address, control, data
+    _busTransactions++;
   }
 }
 
 void Adafruit_SSD1306::display(void) {
-  ssd1306_command(SSD1306_COLUMNADDR);
-  ssd1306_command(0);   // Column start address (0 = reset)
-  ssd1306_command(127); // Column end address (127 = reset)
+  // nothing drawn since the last display()
+  if (_dirtyX0 > _dirtyX1) {
+    _held = false;
+    return;
+  }
+
+  uint8_t x0 = _dirtyX0, x1 = _dirtyX1;
+  uint8_t page0 = _dirtyPage0, page1 = _dirtyPage1;
+
+  // still sending the last frame, leave this one dirty for next time
+  if (_flushing || _dmaBusy) {
+    _held = true;
+    _coalesced++;
+    return;
+  }
+
+  if (_flushThread) {
+    // the worker gets its own copy of the window, so drawing can go on
+    for (uint8_t page=page0; page<=page1; page++) {
+      memcpy(frontBuffer + page * SSD1306_LCDWIDTH + x0, buffer + page * SSD1306_LCDWIDTH + x0, x1 - x0 + 1);
+    }
+    _frontX0 = x0;
+    _frontX1 = x1;
+    _frontPage0 = page0;
+    _frontPage1 = page1;
+    _held = false;
+    _flushing = true;
+    os_semaphore_give(_flushStart, false);
+  }
+  else {
+    sendWindow(buffer, x0, x1, page0, page1);
+  }
 
-  ssd1306_command(SSD1306_PAGEADDR);
-  ssd1306_command(0); // Page start address (0 = reset)
-  ssd1306_command((SSD1306_LCDHEIGHT == 64) ? 7 : 3); // Page end address
+  // clean again
+  _dirtyX0 = SSD1306_LCDWIDTH;
+  _dirtyX1 = -1;
+  _dirtyPage0 = SSD1306_LCDHEIGHT / 8;
+  _dirtyPage1 = -1;
+}
 
-  if (sid != -1)
+void Adafruit_SSD1306::sendWindow(const uint8_t *src, uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1) {
+  uint16_t count = (x1 - x0 + 1) * (page1 - page0 + 1);
+
+  // only the dirty window is addressed, the controller wraps within it
+  const uint8_t window[] = {
+    SSD1306_COLUMNADDR,
+    x0,                   // Column start address
+    x1,                   // Column end address
+    SSD1306_PAGEADDR,
+    page0,                // Page start address
+    page1                 // Page end address
+  };
+  ssd1306_commandList(window, sizeof(window));
+
+  if (_dma)
+  {
+    // hardware SPI by DMA, the window is gathered into one run so it goes
+    // in a single transfer. CS goes high again in dmaDone()
+    uint8_t width = x1 - x0 + 1;
+    for (uint8_t page=page0; page<=page1; page++) {
+      memcpy(spiBuffer + (page - page0) * width, src + page * SSD1306_LCDWIDTH + x0, width);
+    }
+    digitalWrite(cs, HIGH);
+    digitalWrite(dc, HIGH);
+    digitalWrite(cs, LOW);
+    _busBytes += count;
+    _busTransactions++;
+    _dmaBusy = true;
+    SPI.transfer(spiBuffer, NULL, count, dmaDone);
+  }
+  else if (isSPI())
   {
     // SPI
     digitalWrite(cs, HIGH);
@@ -417,33 +522,122 @@ void Adafruit_SSD1306::display(void) {
     digitalWrite(cs, LOW);
 	delayMicroseconds(1);		// May not be necessary - needs testing
 
-    for (uint16_t i=0; i<(SSD1306_LCDWIDTH*SSD1306_LCDHEIGHT/8); i++) {
-      fastSPIwrite(buffer[i]);
-      //ssd1306_data(buffer[i]);
+    for (uint8_t page=page0; page<=page1; page++) {
+      const uint8_t *row = src + page * SSD1306_LCDWIDTH;
+      for (uint8_t x=x0; x<=x1; x++) {
+        fastSPIwrite(row[x]);
+      }
     }
 	delayMicroseconds(1);		// May not be necessary - needs testing
     digitalWrite(cs, HIGH);
+    _busBytes += count;
+    _busTransactions++;
   }
   else
   {
-    // I2C
-    for (uint16_t i=0; i<(SSD1306_LCDWIDTH*SSD1306_LCDHEIGHT/8); i++) {
-      // send a bunch of data in one xmission
-      Wire.beginTransmission(_i2caddr);
-      Wire.write(0x40);
-      for (uint8_t x=0; x<16; x++) {
-		Wire.write(buffer[i]);
-		i++;
-		}
-	i--;
-	Wire.endTransmission();
-	}
+    // I2C, send a bunch of data in one xmission, 16 bytes at a time.
+    // The bus is only held for one xmission, so other I2C users can
+    // get in between when this runs on the flush thread
+    uint8_t n = 0;
+    for (uint8_t page=page0; page<=page1; page++) {
+      const uint8_t *row = src + page * SSD1306_LCDWIDTH;
+      for (uint8_t x=x0; x<=x1; x++) {
+        if (n == 0) {
+          Wire.lock();
+          Wire.beginTransmission(_i2caddr);
+          Wire.write(0x40);
+          _busBytes += 2;     // address, control
+          _busTransactions++;
+        }
+        Wire.write(row[x]);
+        if (++n == 16) {
+          Wire.endTransmission();
+          Wire.unlock();
+          n = 0;
+        }
+      }
+    }
+    if (n) {
+      Wire.endTransmission();
+      Wire.unlock();
+    }
+    _busBytes += count;
+  }
+
+  _bytesSaved += (SSD1306_LCDWIDTH*SSD1306_LCDHEIGHT/8) - count;
+}
+
+void Adafruit_SSD1306::beginAsync(void) {
+  if (_flushThread) return;
+  os_semaphore_create(&_flushStart, 1, 0);
+  _flushThread = new Thread("ssd1306", [this]() { flushLoop(); });
+}
+
+void Adafruit_SSD1306::flushLoop(void) {
+  while (true) {
+    os_semaphore_take(_flushStart, CONCURRENT_WAIT_FOREVER, false);
+    sendWindow(frontBuffer, _frontX0, _frontX1, _frontPage0, _frontPage1);
+    waitForDMA();
+    _flushing = false;
+  }
+}
+
+void Adafruit_SSD1306::waitForFlush(void) {
+  while (true) {
+    while (_flushing || _dmaBusy) {
+      os_thread_yield();
+    }
+    // a held frame goes out now, then wait for that one too
+    if (!_held) return;
+    display();
+  }
+}
+
+bool Adafruit_SSD1306::setDMA(bool dma) {
+  waitForDMA();
+  // dmaDone() has no way to tell whose transfer finished, so only one display gets it
+  if (dma && (!hwSPI || (dmaDisplay && dmaDisplay != this))) {
+    return false;
   }
+  _dma = dma;
+  if (_dma) {
+    dmaDisplay = this;
+  }
+  else if (dmaDisplay == this) {
+    dmaDisplay = NULL;
+  }
+  return true;
+}
+
+void Adafruit_SSD1306::waitForDMA(void) {
+  while (_dmaBusy) {
+    os_thread_yield();
+  }
+}
+
+// runs from the SPI DMA completion interrupt
+void Adafruit_SSD1306::dmaDone(void) {
+  if (dmaDisplay) {
+    digitalWrite(dmaDisplay->cs, HIGH);
+    dmaDisplay->_dmaBusy = false;
+  }
+}
+
+void Adafruit_SSD1306::invalidate(void) {
+  _dirtyX0 = 0;
+  _dirtyX1 = SSD1306_LCDWIDTH - 1;
+  _dirtyPage0 = 0;
+  _dirtyPage1 = (SSD1306_LCDHEIGHT / 8) - 1;
+}
+
+uint8_t *Adafruit_SSD1306::getBuffer(void) {
+  return buffer;
 }
 
 // clear everything
 void Adafruit_SSD1306::clearDisplay(void) {
   memset(buffer, 0, (SSD1306_LCDWIDTH*SSD1306_LCDHEIGHT/8));
+  invalidate();
 }
 
 
@@ -502,12 +696,14 @@ void Adafruit_SSD1306::drawFastHLineInternal(int16_t x, int16_t y, int16_t w, ui
 
   // make sure we don't go off the edge of the display
   if( (x + w) > WIDTH) { 
-    w = (HEIGHT- x);
+    w = (WIDTH - x);
   }
 
   // if our width is now negative, punt
   if(w <= 0) { return; }
 
+  markDirty(x, x + w - 1, y, y);
+
   // set up the pointer for  movement through the buffer
   register uint8_t *pBuf = buffer;
   // adjust the buffer pointer for the current row
@@ -582,6 +778,8 @@ void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y, int16_t __h
     return;
   }
 
+  markDirty(x, x, __y, __y + __h - 1);
+
   // this display doesn't need ints for coordinates, use local byte registers for faster juggling
   register uint8_t y = __y;
   register uint8_t h = __h;
@@ -657,3 +855,146 @@ void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y, int16_t __h
     }
   }
 }
+
+// turn 8 bitmap rows (MSB is the leftmost pixel) into 8 buffer columns
+// (LSB is the top pixel), Hacker's Delight transpose with the rows fed in
+// bottom up so the bit order comes out the way the controller wants it
+static inline void transpose8(const uint8_t *rows, uint8_t *cols) {
+  uint32_t x, y, t;
+
+  x = ((uint32_t)rows[7] << 24) | ((uint32_t)rows[6] << 16) | ((uint32_t)rows[5] << 8) | rows[4];
+  y = ((uint32_t)rows[3] << 24) | ((uint32_t)rows[2] << 16) | ((uint32_t)rows[1] << 8) | rows[0];
+
+  t = (x ^ (x >> 7)) & 0x00AA00AA;  x = x ^ t ^ (t << 7);
+  t = (y ^ (y >> 7)) & 0x00AA00AA;  y = y ^ t ^ (t << 7);
+  t = (x ^ (x >> 14)) & 0x0000CCCC; x = x ^ t ^ (t << 14);
+  t = (y ^ (y >> 14)) & 0x0000CCCC; y = y ^ t ^ (t << 14);
+  t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+  y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+  x = t;
+
+  cols[0] = x >> 24; cols[1] = x >> 16; cols[2] = x >> 8; cols[3] = x;
+  cols[4] = y >> 24; cols[5] = y >> 16; cols[6] = y >> 8; cols[7] = y;
+}
+
+// drawBitmap() a whole buffer byte at a time: each 8x8 block of the bitmap is
+// transposed into page layout and OR'd (WHITE) or cleared (BLACK) in, split over
+// two pages when y isn't a multiple of 8. Only the unrotated screen with the
+// bitmap's top left corner on it takes this path, the right and bottom edges
+// are clipped here, anything else goes pixel by pixel through Adafruit_GFX
+void Adafruit_SSD1306::drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color) {
+  if (rotation != 0 || x < 0 || y < 0) {
+    Adafruit_GFX::drawBitmap(x, y, bitmap, w, h, color);
+    return;
+  }
+  if (x >= WIDTH || y >= HEIGHT || w <= 0 || h <= 0) { return; }
+
+  int16_t byteWidth = (w + 7) / 8;
+  int16_t visibleW = (x + w > WIDTH) ? WIDTH - x : w;
+  int16_t visibleH = (y + h > HEIGHT) ? HEIGHT - y : h;
+  uint8_t shift = y & 7;
+  uint8_t rows[8], cols[8];
+
+  markDirty(x, x + visibleW - 1, y, y + visibleH - 1);
+
+  for (int16_t j=0; j<visibleH; j+=8) {
+    uint8_t count = (visibleH - j < 8) ? visibleH - j : 8;
+    // the rows land in this page and, if they run past its bottom, the next
+    uint8_t *page = buffer + ((y + j) / 8) * SSD1306_LCDWIDTH + x;
+    bool spill = shift + count > 8;
+    const uint8_t *src = bitmap + j * byteWidth;
+
+    for (int16_t bx=0; bx<byteWidth && bx*8<visibleW; bx++) {
+      uint8_t any = 0;
+      for (uint8_t r=0; r<8; r++) {
+        rows[r] = (r < count) ? src[r * byteWidth + bx] : 0;
+        any |= rows[r];
+      }
+      // nothing set, nothing to draw
+      if (!any) { continue; }
+
+      transpose8(rows, cols);
+
+      uint8_t n = (visibleW - bx*8 < 8) ? visibleW - bx*8 : 8;
+      uint8_t *dst = page + bx*8;
+      for (uint8_t c=0; c<n; c++) {
+        uint8_t low = cols[c] << shift;
+        uint8_t high = spill ? cols[c] >> (8 - shift) : 0;
+        if (color == WHITE) {
+          dst[c] |= low;
+          if (high) { dst[c + SSD1306_LCDWIDTH] |= high; }
+        } else {
+          dst[c] &= ~low;
+          if (high) { dst[c + SSD1306_LCDWIDTH] &= ~high; }
+        }
+      }
+    }
+  }
+}
+
+// drawChar() straight into the buffer. The font is already one byte per
+// column with the top pixel in the LSB, the same as a page, so a size 1
+// character on a page boundary is 6 byte stores. Off a boundary each column
+// is split over two pages, and at size N each bit is repeated N times down
+// the column and the column N times across. Sizes past 7 don't fit the 64
+// bit column, they and anything rotated or not wholly on the screen go
+// through Adafruit_GFX
+void Adafruit_SSD1306::drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size) {
+  if (rotation != 0 || size < 1 || size > 7 ||
+      x < 0 || y < 0 || x + 6 * size > WIDTH || y + 8 * size > HEIGHT) {
+    Adafruit_GFX::drawChar(x, y, c, color, bg, size);
+    return;
+  }
+
+  const uint8_t *columns = glyph(c);
+  uint8_t shift = y & 7;
+  uint8_t pages = (shift + 8 * size + 7) / 8;
+  uint64_t fill = (1 << size) - 1;
+  uint64_t mask = ((((uint64_t)1) << (8 * size)) - 1) << shift;
+  bool opaque = (bg != color);
+  uint8_t *dst = buffer + (y / 8) * SSD1306_LCDWIDTH + x;
+
+  markDirty(x, x + 6 * size - 1, y, y + 8 * size - 1);
+
+  for (uint8_t i=0; i<6; i++) {
+    uint8_t line = (i == 5) ? 0 : columns[i];
+    uint64_t bits = 0;
+
+    // transparent and nothing set in this column, nothing to do
+    if (!line && !opaque) {
+      dst += size;
+      continue;
+    }
+
+    if (size == 1) {
+      bits = line;
+    }
+    else {
+      for (uint8_t j=0; j<8; j++) {
+        if (line & (1 << j)) { bits |= fill << (j * size); }
+      }
+    }
+    bits <<= shift;
+
+    for (uint8_t k=0; k<size; k++) {
+      uint8_t *col = dst++;
+      for (uint8_t p=0; p<pages; p++) {
+        uint8_t set = bits >> (8 * p);
+        uint8_t covered = mask >> (8 * p);
+
+        if (opaque) {
+          // every covered pixel is drawn, in color where the font is set and bg elsewhere
+          uint8_t value = ((color == WHITE) ? set : 0) | ((bg == WHITE) ? (covered & ~set) : 0);
+          *col = (*col & ~covered) | value;
+        }
+        else if (color == WHITE) {
+          *col |= set;
+        }
+        else {
+          *col &= ~set;
+        }
+        col += SSD1306_LCDWIDTH;
+      }
+    }
+  }
+}
@@ -16,15 +16,19 @@ BSD license, check license.txt for more information
 All text above, and the splash screen must be included in any redistribution
 *********************************************************************/
 
+#ifndef _ADAFRUIT_SSD1306_H
+#define _ADAFRUIT_SSD1306_H
 
 #include "application.h"
 #include "Adafruit_GFX.h"
+#include <atomic>
 
 
 #define BLACK 0
 #define WHITE 1
 
 #define SSD1306_I2C_ADDRESS   0x3C	// 011110+SA0+RW - 0x3C or 0x3D
+#define SSD1306_I2C_COMMANDS  31	// command bytes per transmission, the Wire buffer is 32 with the control byte
 // Address for 128x32 is 0x3C
 // Address for 128x64 is 0x3D (default) or 0x3C (if SA0 is grounded)
 
@@ -114,6 +118,7 @@ class Adafruit_SSD1306 : public Adafruit_GFX {
 
   void begin(uint8_t switchvcc = SSD1306_SWITCHCAPVCC, uint8_t i2caddr = SSD1306_I2C_ADDRESS);
   void ssd1306_command(uint8_t c);
+  void ssd1306_commandList(const uint8_t *c, uint8_t n);
   void ssd1306_data(uint8_t c);
 
   void clearDisplay(void);
@@ -133,15 +138,74 @@ class Adafruit_SSD1306 : public Adafruit_GFX {
 
   virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
   virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  virtual void drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color);
+  virtual void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size);
+
+  // display() only sends the part of the buffer drawn on since the last display()
+  void invalidate(void);                  // send the whole buffer next time
+  uint8_t *getBuffer(void);              // the frame buffer itself, call invalidate() after writing to it
+  uint32_t bytesSaved(void) { return _bytesSaved; }   // buffer bytes not sent thanks to the dirty window
+  uint32_t busBytes(void) { return _busBytes; }       // bytes put on the bus, commands and data
+  uint32_t busTransactions(void) { return _busTransactions; }  // I2C transmissions or SPI CS cycles
+
+  // after beginAsync() display() copies the dirty window to a front buffer and a
+  // worker thread sends it, drawing carries on in the back buffer meanwhile.
+  // A display() while the worker is busy is held, its window stays dirty and goes
+  // out with the next display() or waitForFlush()
+  void beginAsync(void);
+  void waitForFlush(void);                // returns once everything displayed is on the screen
+  bool flushing(void) { return _flushing || _dmaBusy; }
+  bool pending(void) { return _held; }    // the last display() was held
+  uint32_t coalescedFrames(void) { return _coalesced; }  // display() calls held and folded into a later frame
+
+  // hardware SPI only, frames go out by DMA. display() returns once the transfer
+  // is started, and a display() while it is still running is held as above.
+  // The completion callback is shared, so only one display can use DMA at a
+  // time. Returns false, and stays on blocking SPI, for an I2C or software SPI
+  // display or while another display has DMA. setDMA(false) hands it back
+  bool setDMA(bool dma);
 
  private:
   int8_t _i2caddr, _vccstate, sid, sclk, dc, rst, cs;
   void fastSPIwrite(uint8_t c);
 
   boolean hwSPI;
+  // sid and sclk are only set for software SPI, both SPI constructors take a CS
+  bool isSPI(void) { return hwSPI || sid != -1; }
+
+  // dirty window in buffer coordinates, _dirtyX0 > _dirtyX1 when clean
+  int16_t _dirtyX0, _dirtyX1;
+  int8_t _dirtyPage0, _dirtyPage1;
+  // counted by both the loop and the flush thread
+  std::atomic<uint32_t> _bytesSaved, _busBytes, _busTransactions;
+
+  // async flush, the worker only reads _front* and sets _flushing false when done
+  Thread *_flushThread;
+  os_semaphore_t _flushStart;
+  volatile bool _flushing;
+  bool _held;
+  uint32_t _coalesced;
+  uint8_t _frontX0, _frontX1, _frontPage0, _frontPage1;
+
+  void sendWindow(const uint8_t *src, uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1);
+  void flushLoop(void);
+
+  // DMA transfer, dmaDone() clears _dmaBusy from the completion interrupt
+  bool _dma;
+  volatile bool _dmaBusy;
+  void waitForDMA(void);
+  static void dmaDone(void);
+
+  inline void markDirty(int16_t x0, int16_t x1, int16_t y0, int16_t y1) __attribute__((always_inline)) {
+    if (x0 < _dirtyX0) _dirtyX0 = x0;
+    if (x1 > _dirtyX1) _dirtyX1 = x1;
+    if ((y0 >> 3) < _dirtyPage0) _dirtyPage0 = y0 >> 3;
+    if ((y1 >> 3) > _dirtyPage1) _dirtyPage1 = y1 >> 3;
+  }
 
   inline void drawFastVLineInternal(int16_t x, int16_t y, int16_t h, uint16_t color) __attribute__((always_inline));
   inline void drawFastHLineInternal(int16_t x, int16_t y, int16_t w, uint16_t color) __attribute__((always_inline));
 
 };
 
+#endif // _ADAFRUIT_SSD1306_H
@@ -1,11 +1,34 @@
 #ifndef _BUTTON_H_
 #define _BUTTON_H_
 
+// events queued by a button started with begin()
+enum ButtonEvent {
+  BUTTON_NONE = -1,
+  BUTTON_PRESS,
+  BUTTON_RELEASE,
+  BUTTON_CLICK,           // released before the long press time
+  BUTTON_LONG_PRESS,      // released after the long press time
+  BUTTON_DOUBLE_CLICK     // second click soon after the first, follows its BUTTON_CLICK
+};
+
 class Button {
   int _buttonPin;
   int _prevButtonState;
   bool _pullUp;
 
+  // interrupt mode, only used after begin()
+  static const unsigned int QUEUE = 16;   // power of 2 so the counters can wrap
+  unsigned int _debounce, _longPress, _doubleClick;
+  volatile bool _pressed;                 // debounced state
+  volatile bool _unsettled;               // an edge was ignored, the pin may not match _pressed
+  volatile unsigned int _lastEdge;        // millis() of the last accepted edge
+  volatile unsigned int _pressTime;
+  volatile unsigned int _lastClick;
+  volatile bool _clicked;                 // _lastClick is valid
+  volatile int8_t _queue[QUEUE];
+  volatile unsigned int _head, _tail;     // the interrupt writes _head, nextEvent() writes _tail
+  volatile unsigned int _dropped;
+
   public:
     Button(int buttonPin, bool pullUp=false) {
       _buttonPin = buttonPin;
@@ -15,8 +38,50 @@ class Button {
         pinMode(_buttonPin,INPUT_PULLUP);
       }
       else {
-        pinMode(_buttonPin,INPUT_PULLDOWN);       
+        pinMode(_buttonPin,INPUT_PULLDOWN);
+      }
+      _pressed = _unsettled = _clicked = false;
+      _lastEdge = _pressTime = _lastClick = 0;
+      _head = _tail = _dropped = 0;
+    }
+
+    // switch to interrupt mode, edges closer than debounce ms to the last one are bounce
+    void begin(unsigned int debounce=20, unsigned int longPress=800, unsigned int doubleClick=400) {
+      _debounce = debounce;
+      _longPress = longPress;
+      _doubleClick = doubleClick;
+      _pressed = readPin();
+      _lastEdge = millis();
+      attachInterrupt(_buttonPin,&Button::onChange,this,CHANGE);
+    }
+
+    // oldest event not read yet, BUTTON_NONE if there isn't one
+    int nextEvent() {
+      unsigned int tail;
+      int event;
+
+      // bounce that ended after the last accepted edge left no edge to catch,
+      // pick up the real state once it has had time to settle
+      if (_unsettled && millis() - _lastEdge >= _debounce) {
+        ATOMIC_BLOCK() {
+          _unsettled = false;
+          if (readPin() != _pressed) {
+            changed(!_pressed,millis());
+          }
+        }
+      }
+
+      tail = _tail;
+      if (tail == _head) {
+        return BUTTON_NONE;
       }
+      event = _queue[tail % QUEUE];
+      _tail = tail + 1;
+      return event;
+    }
+
+    unsigned int dropped() {
+      return _dropped;
     }
 
     bool isPressed() {
@@ -30,21 +95,78 @@ class Button {
     }
 
     bool isClicked() {
-      bool _buttonState, _clicked;
+      bool state, clicked;
 
-      _buttonState = digitalRead(_buttonPin);
+      state = digitalRead(_buttonPin);
       if(_pullUp) {
-        _buttonState = !_buttonState;
+        state = !state;
       }
-      if(_buttonState != _prevButtonState) {
-        _clicked = _buttonState;
+      if(state != _prevButtonState) {
+        clicked = state;
       }
       else {
+        clicked = false;
+      }
+      _prevButtonState=state;
+      return clicked;
+    }
+
+  private:
+    bool readPin() {
+      bool state = pinReadFast(_buttonPin);
+      return _pullUp ? !state : state;
+    }
+
+    void onChange() {
+      unsigned int now = millis();
+      bool state = readPin();
+
+      if (state == _pressed) {
+        return;
+      }
+      if (now - _lastEdge < _debounce) {
+        _unsettled = true;
+        return;
+      }
+      changed(state,now);
+    }
+
+    // a debounced change, interrupts are off when this runs
+    void changed(bool state, unsigned int now) {
+      _pressed = state;
+      _lastEdge = now;
+      if (state) {
+        _pressTime = now;
+        post(BUTTON_PRESS);
+        return;
+      }
+
+      post(BUTTON_RELEASE);
+      if (now - _pressTime >= _longPress) {
+        post(BUTTON_LONG_PRESS);
         _clicked = false;
+        return;
+      }
+      post(BUTTON_CLICK);
+      if (_clicked && now - _lastClick <= _doubleClick) {
+        post(BUTTON_DOUBLE_CLICK);
+        _clicked = false;   // a third click starts over
+        return;
+      }
+      _clicked = true;
+      _lastClick = now;
+    }
+
+    void post(ButtonEvent event) {
+      unsigned int head = _head;
+
+      if (head - _tail >= QUEUE) {
+        _dropped++;
+        return;
       }
-      _prevButtonState=_buttonState;
-      return _clicked;
+      _queue[head % QUEUE] = event;
+      _head = head + 1;
     }
 };
 
-#endif // _BUTTON_H_
\ No newline at end of file
+#endif // _BUTTON_H_
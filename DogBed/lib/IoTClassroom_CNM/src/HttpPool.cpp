@@ -0,0 +1,8 @@
+/*
+ *  Project: IoT Classroom Library
+ *  Description: The connection pool shared by the Hue and Wemo code
+ */
+
+#include "HttpPool.h"
+
+HttpPool httpPool;
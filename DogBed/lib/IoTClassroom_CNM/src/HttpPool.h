@@ -0,0 +1,166 @@
+#ifndef _HTTPPOOL_H_
+#define _HTTPPOOL_H_
+
+/*
+ *  Project: IoT Classroom Library
+ *  Description: Small pool of keep-alive TCP connections shared by the Hue
+ *               and Wemo code, so each command doesn't pay for a new handshake
+ */
+
+#include "application.h"
+
+/* Usage:
+ * TCPClient *client = httpPool.send(host, port, request, length);  // NULL if it couldn't be sent
+ * if (client) {
+ *   client->readString();      // the answer, if it is wanted
+ * }
+ *
+ * TCPClient *client = httpPool.connect(host, port);  // NULL if it can't connect
+ * httpPool.close(client);      // only if the connection went bad
+ *
+ * Anything left unread on a reused connection is thrown away before the
+ * next request goes out, so the caller only ever reads its own answer.
+ * A connection the other side closed is found the next time it is asked
+ * for and reconnected, the caller never sees it. One that closes while a
+ * request is being written is caught by send(), which reconnects and
+ * writes the request again once.
+ */
+
+class HttpPool {
+
+  static const int SLOTS = 4;
+
+  struct Slot {
+    TCPClient client;
+    const char *host;         // NULL when the slot is free
+    uint16_t port;
+    unsigned int lastUsed;
+  };
+
+  Slot _slots[SLOTS];
+  unsigned int _hits, _misses, _stale, _retries;
+
+  public:
+    HttpPool() {
+      for (int i=0; i<SLOTS; i++) {
+        _slots[i].host = NULL;
+        _slots[i].port = 0;
+        _slots[i].lastUsed = 0;
+      }
+      _hits = _misses = _stale = _retries = 0;
+    }
+
+    // returns an open connection to host:port, reusing one if it is still up
+    TCPClient *connect(const char *host, uint16_t port) {
+      Slot *slot = find(host,port);
+
+      if (slot) {
+        flush(&slot->client);
+        if (slot->client.connected()) {
+          _hits++;
+          slot->lastUsed = millis();
+          return &slot->client;
+        }
+        // the other side hung up since we last used it
+        _stale++;
+        slot->client.stop();
+      }
+      else {
+        slot = oldest();
+        if (slot->host) {
+          slot->client.stop();
+        }
+      }
+
+      _misses++;
+      slot->host = host;
+      slot->port = port;
+      slot->lastUsed = millis();
+      if (!slot->client.connect(host,port)) {
+        slot->host = NULL;
+        return NULL;
+      }
+      return &slot->client;
+    }
+
+    // write a whole request, returns the connection to read the answer from,
+    // or NULL if it couldn't be sent. A failed or short write closes the
+    // connection and the request goes again on a new one
+    TCPClient *send(const char *host, uint16_t port, const uint8_t *data, size_t length) {
+      TCPClient *client;
+
+      for (int attempt=0; attempt<2; attempt++) {
+        client = connect(host,port);
+        if (!client) {
+          return NULL;
+        }
+        // the answer read after this has to be this request's, not what
+        // is left of the last one or came in since connect()
+        flush(client);
+        if (client->write(data,length) == length) {
+          return client;
+        }
+        close(client);
+        if (attempt == 0) {
+          _retries++;
+        }
+      }
+      return NULL;
+    }
+
+    // drop a connection that failed part way through a request
+    void close(TCPClient *client) {
+      for (int i=0; i<SLOTS; i++) {
+        if (&_slots[i].client == client) {
+          _slots[i].client.stop();
+          _slots[i].host = NULL;
+        }
+      }
+    }
+
+    unsigned int hits() { return _hits; }
+    unsigned int misses() { return _misses; }
+    unsigned int staleCount() { return _stale; }
+    unsigned int retries() { return _retries; }
+
+    void printStats() {
+      Serial.printf("Connections: %u reused, %u opened, %u found closed, %u writes retried\n",_hits,_misses,_stale,_retries);
+    }
+
+  private:
+    // throw away whatever is left of the last response on a reused connection
+    void flush(TCPClient *client) {
+      while (client->available()) {
+        client->read();
+      }
+    }
+
+    Slot *find(const char *host, uint16_t port) {
+      for (int i=0; i<SLOTS; i++) {
+        if (_slots[i].host && _slots[i].port == port && strcmp(_slots[i].host,host) == 0) {
+          return &_slots[i];
+        }
+      }
+      return NULL;
+    }
+
+    // a free slot if there is one, otherwise the least recently used
+    Slot *oldest() {
+      Slot *slot = &_slots[0];
+
+      for (int i=0; i<SLOTS; i++) {
+        if (!_slots[i].host) {
+          return &_slots[i];
+        }
+        if ((int)(_slots[i].lastUsed - slot->lastUsed) < 0) {
+          slot = &_slots[i];
+        }
+      }
+      return slot;
+    }
+};
+
+// the one the Hue and Wemo functions share, in HttpPool.cpp
+extern HttpPool httpPool;
+
+#endif // _HTTPPOOL_H_
@@ -1,5 +1,7 @@
 #include "Particle.h"
 #include "hue.h"
 #include "wemo.h"
+#include "WemoQueue.h"
 #include "IoTTimer.h"
-#include "Button.h"
\ No newline at end of file
+#include "Button.h"
+#include "Joystick.h"
\ No newline at end of file
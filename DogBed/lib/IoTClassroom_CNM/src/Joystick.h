@@ -0,0 +1,199 @@
+#ifndef _JOYSTICK_H_
+#define _JOYSTICK_H_
+
+/*
+ *  Project: IoT Classroom Library
+ *  Description: Two axis analog joystick sampled on its own timer. Each axis
+ *               is averaged and given hysteresis, and pushes come out as
+ *               up/down/left/right gestures in a queue, with auto-repeat
+ *               while the stick is held
+ */
+
+#include "application.h"
+
+/* Usage:
+ * Joystick joystick(A1, A2);          // horizontal pin, vertical pin
+ * joystick.begin();                   // in setup(), starts the sampling timer
+ * joystick.setRepeat(500, 150);       // optional, repeat a held push
+ *
+ * int gesture = joystick.nextGesture();  // JOY_NONE if nothing happened
+ *
+ * A high reading on the horizontal pin is right, a high reading on the
+ * vertical pin is down.
+ */
+
+enum JoyGesture {
+  JOY_NONE = -1,
+  JOY_UP,
+  JOY_DOWN,
+  JOY_LEFT,
+  JOY_RIGHT
+};
+
+class Joystick {
+
+  static const int AVERAGE = 4;       // samples averaged per axis
+  static const unsigned int QUEUE = 8;  // power of 2 so the counters can wrap
+
+  // a push starts past the outer threshold and ends back inside the inner one
+  static const int PUSH_LOW = 1000;
+  static const int RELEASE_LOW = 1500;
+  static const int RELEASE_HIGH = 2500;
+  static const int PUSH_HIGH = 3000;
+
+  struct Axis {
+    int pin;
+    int samples[AVERAGE];
+    int sum;
+    int direction;                // -1 low, 0 centered, 1 high
+    bool repeat;                  // auto-repeat a held push on this axis
+    unsigned int nextRepeat;      // millis() of the next repeat
+    JoyGesture low, high;         // gesture for each end of the axis
+  };
+
+  Axis _axes[2];
+  int _next;                      // next slot in the averaging ring
+  unsigned int _period;
+  unsigned int _repeatDelay;      // 0 turns auto-repeat off
+  unsigned int _repeatRate;
+  Timer _timer;
+
+  // the timer thread writes _head, nextGesture() writes _tail
+  volatile int8_t _queue[QUEUE];
+  volatile unsigned int _head;
+  volatile unsigned int _tail;
+  volatile unsigned int _dropped;
+
+  public:
+    Joystick(int horizontalPin, int verticalPin, unsigned int period=10) :
+      _timer(period, &Joystick::sample, *this) {
+      initAxis(_axes[0], horizontalPin, JOY_LEFT, JOY_RIGHT);
+      initAxis(_axes[1], verticalPin, JOY_UP, JOY_DOWN);
+      _next = 0;
+      _period = period;
+      _repeatDelay = 0;
+      _repeatRate = 0;
+      _head = _tail = 0;
+      _dropped = 0;
+    }
+
+    void begin() {
+      _timer.start();
+    }
+
+    // a push held for delay ms repeats every rate ms, by default only up and down repeat
+    void setRepeat(unsigned int delay, unsigned int rate, bool vertical=true, bool horizontal=false) {
+      _repeatDelay = delay;
+      _repeatRate = rate;
+      _axes[0].repeat = horizontal;
+      _axes[1].repeat = vertical;
+    }
+
+    // the oldest gesture not read yet, JOY_NONE if there isn't one
+    int nextGesture() {
+      unsigned int tail = _tail;
+      int gesture;
+
+      if (tail == _head) {
+        return JOY_NONE;
+      }
+      gesture = _queue[tail % QUEUE];
+      _tail = tail + 1;
+      return gesture;
+    }
+
+    // gestures lost because nobody read them
+    unsigned int dropped() {
+      return _dropped;
+    }
+
+  private:
+    void initAxis(Axis &axis, int pin, JoyGesture low, JoyGesture high) {
+      axis.pin = pin;
+      // start out centered so the first samples don't look like a push
+      for (int i=0; i<AVERAGE; i++) {
+        axis.samples[i] = 2048;
+      }
+      axis.sum = 2048 * AVERAGE;
+      axis.direction = 0;
+      axis.repeat = false;
+      axis.nextRepeat = 0;
+      axis.low = low;
+      axis.high = high;
+    }
+
+    // runs on the timer every _period ms
+    void sample() {
+      unsigned int now = millis();
+
+      for (int i=0; i<2; i++) {
+        sampleAxis(_axes[i], now);
+      }
+      _next = (_next + 1) % AVERAGE;
+    }
+
+    void sampleAxis(Axis &axis, unsigned int now) {
+      int reading = analogRead(axis.pin);
+      int average;
+
+      axis.sum += reading - axis.samples[_next];
+      axis.samples[_next] = reading;
+      average = axis.sum / AVERAGE;
+
+      switch (axis.direction) {
+        case 0:
+          if (average < PUSH_LOW) {
+            push(axis, -1, now);
+          }
+          else if (average > PUSH_HIGH) {
+            push(axis, 1, now);
+          }
+          break;
+
+        case -1:
+          if (average > RELEASE_LOW) {
+            axis.direction = 0;
+          }
+          else {
+            holding(axis, now);
+          }
+          break;
+
+        case 1:
+          if (average < RELEASE_HIGH) {
+            axis.direction = 0;
+          }
+          else {
+            holding(axis, now);
+          }
+          break;
+      }
+    }
+
+    void push(Axis &axis, int direction, unsigned int now) {
+      axis.direction = direction;
+      axis.nextRepeat = now + _repeatDelay;
+      post(direction < 0 ? axis.low : axis.high);
+    }
+
+    void holding(Axis &axis, unsigned int now) {
+      if (!axis.repeat || _repeatDelay == 0 || (int)(now - axis.nextRepeat) < 0) {
+        return;
+      }
+      axis.nextRepeat = now + _repeatRate;
+      post(axis.direction < 0 ? axis.low : axis.high);
+    }
+
+    void post(JoyGesture gesture) {
+      unsigned int head = _head;
+
+      if (head - _tail >= QUEUE) {
+        _dropped++;
+        return;
+      }
+      _queue[head % QUEUE] = gesture;
+      _head = head + 1;
+    }
+};
+
+#endif // _JOYSTICK_H_
@@ -0,0 +1,171 @@
+#ifndef _WEMOQUEUE_H_
+#define _WEMOQUEUE_H_
+
+/*
+ *  Project: Wemo IoT Library
+ *  Description: Queue of Wemo on/off requests that returns right away.
+ *               The connect and send run on a worker thread, so a slow or
+ *               missing outlet never holds up loop(). pump() is called from
+ *               loop(), hands the worker the next request and collects the
+ *               result of the last one. The worker keeps its connections
+ *               open in its own pool for reuse
+ */
+
+#include "application.h"
+#include "wemo.h"
+#include <atomic>
+
+/* Usage:
+ * WemoQueue outlets;
+ * outlets.begin();               // in setup(), starts the worker thread
+ * outlets.write(outlet, state);  // in place of wemoWrite(), returns right away
+ * outlets.pump();                // every pass through loop()
+ *
+ * A second write to the same outlet before the first one went out replaces
+ * it, only the last state asked for is sent. Without begin() pump() sends
+ * the request itself and blocks like wemoWrite() does.
+ */
+
+class WemoQueue {
+
+  static const int OUTLETS = sizeof(wemoIP) / sizeof(wemoIP[0]);
+  static const int8_t NOREQUEST = -1;
+
+  // the loop owns the active request in IDLE and DONE, the worker in WORKING
+  enum Step { IDLE, WORKING, DONE };
+
+  int8_t _pending[OUTLETS];   // state waiting to go out for each outlet, or NOREQUEST
+  int _nextOutlet;            // where to start looking for the next request
+  int _activeOutlet;
+  bool _activeState;
+  bool _delivered;            // the worker's answer, read once _step is DONE
+  std::atomic<Step> _step;
+  Thread *_worker;
+  os_semaphore_t _workStart;
+  HttpPool _pool;             // only the worker uses it, so it needs no lock
+  unsigned int _sent, _failed, _collapsed;
+
+  public:
+    WemoQueue() {
+      for (int i=0; i<OUTLETS; i++) {
+        _pending[i] = NOREQUEST;
+      }
+      _nextOutlet = 0;
+      _activeOutlet = 0;
+      _activeState = false;
+      _delivered = false;
+      _step = IDLE;
+      _worker = NULL;
+      _sent = _failed = _collapsed = 0;
+    }
+
+    // start the worker, the constructor runs before threads can be made
+    void begin() {
+      if (_worker) {
+        return;
+      }
+      os_semaphore_create(&_workStart,1,0);
+      _worker = new Thread("wemo",[this]() { workLoop(); });
+    }
+
+    // queue an on/off for an outlet, last writer wins
+    bool write(int outlet, bool wemoState) {
+      if (outlet < 0 || outlet >= OUTLETS) {
+        return false;
+      }
+      if (_pending[outlet] != NOREQUEST) {
+        _collapsed++;
+      }
+      _pending[outlet] = wemoState;
+      return true;
+    }
+
+    // start the next request or collect the last one, returns true while there is work left
+    bool pump() {
+      switch (_step) {
+        case IDLE:
+          if (!nextRequest()) {
+            return false;
+          }
+          Serial.printf("Switching %s Wemo #%i\n",_activeState ? "On" : "Off",_activeOutlet);
+          if (_worker) {
+            _step = WORKING;
+            os_semaphore_give(_workStart,false);
+          }
+          else {
+            send();
+          }
+          break;
+
+        case WORKING:
+          // still connecting or sending
+          break;
+
+        case DONE:
+          if (_delivered) {
+            _sent++;
+          }
+          else {
+            Serial.printf("Wemo #%i did not take the request\n",_activeOutlet);
+            _failed++;
+          }
+          _step = IDLE;
+          break;
+      }
+      return busy();
+    }
+
+    bool busy() {
+      if (_step != IDLE) {
+        return true;
+      }
+      for (int i=0; i<OUTLETS; i++) {
+        if (_pending[i] != NOREQUEST) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    unsigned int sentCount() { return _sent; }
+    unsigned int failedCount() { return _failed; }
+    unsigned int collapsedCount() { return _collapsed; }
+
+    void printStats() {
+      Serial.printf("Wemo: %u sent, %u failed, %u replaced before they went out\n",_sent,_failed,_collapsed);
+      _pool.printStats();
+    }
+
+  private:
+    // take the next pending request, going round the outlets so none starve
+    bool nextRequest() {
+      int outlet;
+
+      for (int i=0; i<OUTLETS; i++) {
+        outlet = (_nextOutlet + i) % OUTLETS;
+        if (_pending[outlet] != NOREQUEST) {
+          _activeOutlet = outlet;
+          _activeState = _pending[outlet];
+          _pending[outlet] = NOREQUEST;
+          _nextOutlet = (outlet + 1) % OUTLETS;
+          return true;
+        }
+      }
+      return false;
+    }
+
+    // the blocking part, connects if it has to and writes the request
+    void send() {
+      _delivered = wemoSend(_activeOutlet,_activeState,_pool);
+      _step = DONE;
+    }
+
+    void workLoop() {
+      while (true) {
+        os_semaphore_take(_workStart,CONCURRENT_WAIT_FOREVER,false);
+        send();
+      }
+    }
+};
+
+#endif // _WEMOQUEUE_H_
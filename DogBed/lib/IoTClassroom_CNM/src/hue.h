@@ -9,6 +9,7 @@
  */
 
 #include "application.h"
+#include "HttpPool.h"
 
 /* Usage:
  * setHue(int lightNum, bool HueOn, int HueColor, int HueBright, int HueSat);
@@ -44,10 +45,9 @@ int HueIndigo = 47500;
 int HueViolet = 50000;
 int HueRainbow[] = {HueRed, HueOrange, HueYellow, HueGreen, HueBlue, HueIndigo, HueViolet};
 
-TCPClient HueClient;
-
 bool setHue(int lightNum, bool HueOn, int HueColor=HueBlue, int HueBright=255, int HueSat=255);
 bool getHue(int lightNum);
+String hueField(const String &body, const char *name);
 
 bool setHue(int lightNum, bool HueOn, int HueColor, int HueBright, int HueSat) {
 
@@ -80,77 +80,93 @@ bool setHue(int lightNum, bool HueOn, int HueColor, int HueBright, int HueSat) {
     command = "{\"on\":false}";
   }
 
-  if (HueClient.connect(hueHubIP, hueHubPort)) {
-    //while (HueClient.connected())
-    //{
-      // Serial.println("Sending Command to Hue");
-      // Serial.println(command);
-      Serial.printf("Sending Command to Hue: %s\n",command.c_str());
-      HueClient.print("PUT /api/");
-      HueClient.print(hueUsername);
-      HueClient.print("/lights/");
-      HueClient.print(lightNum);  // hueLight zero based, add 1
-      //  HueClient.println("/state");
-      HueClient.println("/state HTTP/1.1");
-      HueClient.println("keep-alive");
-      HueClient.print("Host: ");
-      HueClient.println(hueHubIP);
-      HueClient.print("Content-Length: ");
-      HueClient.println(command.length());
-      HueClient.println("Content-Type: text/plain;charset=UTF-8");
-      HueClient.println();  // blank line before body
-      HueClient.println(command);  // Hue command
-      HueClient.readString();
-      // Serial.println("From Hue");
-      // Serial.println(HueClient.readString()); // To close connection
-    HueClient.stop();
+  // connections to the hub are kept open and reused, see HttpPool.h
+  String request = String("PUT /api/") + hueUsername + "/lights/" + String(lightNum) + "/state HTTP/1.1\r\n";
+  request = request + "Connection: keep-alive\r\n";
+  request = request + "Host: " + hueHubIP + "\r\n";
+  request = request + "Content-Length: " + String(command.length()) + "\r\n";
+  request = request + "Content-Type: text/plain;charset=UTF-8\r\n";
+  request = request + "\r\n";   // blank line before body
+  request = request + command;    // Hue command, exactly Content-Length bytes
+
+  Serial.printf("Sending Command to Hue: %s\n",command.c_str());
+  // the response is thrown away the next time the connection is used
+  if (httpPool.send(hueHubIP,hueHubPort,(const uint8_t *)request.c_str(),request.length())) {
     return true;  // command executed
   }
   else
     return false;  // command failed
 }
 
+// the value after name in the light's JSON, up to the next comma or brace
+String hueField(const String &body, const char *name) {
+  int start = body.indexOf(name);
+  int end;
+
+  if (start < 0) {
+    return String();
+  }
+  start += strlen(name);
+  end = start;
+  while (end < (int)body.length() && body.charAt(end) != ',' && body.charAt(end) != '}') {
+    end++;
+  }
+  return body.substring(start,end);
+}
 
 bool getHue(int lightNum) {
-  if (HueClient.connect(hueHubIP, hueHubPort))
-  {
-    HueClient.print("GET /api/");
-    HueClient.print(hueUsername);
-    HueClient.print("/lights/");
-    HueClient.print(lightNum);  
-    HueClient.println(" HTTP/1.1");
-    HueClient.print("Host: ");
-    HueClient.println(hueHubIP);
-    HueClient.println("Content-type: application/json");
-    HueClient.println("keep-alive");
-    HueClient.println();
-    //while (HueClient.connected())
-    //{
-    //  if (HueClient.available()) {
-        Serial.println();
-        Serial.println(HueClient.readString());
-        Serial.println();
-        HueClient.findUntil("\"on\":", "\0");
-        hueOn = (HueClient.readStringUntil(',') == "true");  // if light is on, set variable to true
-        Serial.print("Hue Status: ");
-        Serial.println(hueOn);
- 
-        HueClient.findUntil("\"bri\":", "\0");
-        hueBri = HueClient.readStringUntil(',').toInt();  // set variable to brightness value
-        Serial.println(hueBri);
-        
-        HueClient.findUntil("\"hue\":", "\0");
-        hueHue = HueClient.readStringUntil(',').toInt();  // set variable to hue value
-        Serial.printf("Hue is\n\n\n %i\n",hueHue);
-        
-        //break;  // not capturing other light attributes yet
-    //  }
-    //}
-    HueClient.stop();
-    return true;  // captured on,bri,hue
+  String request = String("GET /api/") + hueUsername + "/lights/" + String(lightNum) + " HTTP/1.1\r\n";
+  request = request + "Host: " + hueHubIP + "\r\n";
+  request = request + "Content-type: application/json\r\n";
+  request = request + "Connection: keep-alive\r\n";
+  request = request + "\r\n";
+
+  TCPClient *HueClient = httpPool.send(hueHubIP,hueHubPort,(const uint8_t *)request.c_str(),request.length());
+  if (!HueClient) {
+    return false;  // error reading on,bri,hue
+  }
+
+  // the connection stays open, so read just the body instead of waiting for it to close
+  String body, line;
+  int length = -1;
+  // the headers, up to the blank line
+  do {
+    line = HueClient->readStringUntil('\n');
+    if (line.indexOf("Content-Length:") == 0) {
+      length = line.substring(15).toInt();
+    }
+  } while (line.length() > 1);
+  if (length <= 0) {
+    return false;
   }
- else
-   return false;  // error reading on,bri,hue
+  char chunk[65];
+  size_t got;
+  while (length > 0) {
+    got = HueClient->readBytes(chunk,min(length,64));
+    if (got == 0) {
+      break;
+    }
+    chunk[got] = 0;
+    body = body + chunk;
+    length -= got;
+  }
+  Serial.println(body);
+
+  String on = hueField(body,"\"on\":");
+  if (on.length() == 0) {
+    return false;
+  }
+  hueOn = (on == "true");  // if light is on, set variable to true
+  Serial.print("Hue Status: ");
+  Serial.println(hueOn);
+
+  hueBri = hueField(body,"\"bri\":").toInt();  // set variable to brightness value
+  Serial.println(hueBri);
+
+  hueHue = hueField(body,"\"hue\":").toInt();  // set variable to hue value
+  Serial.printf("Hue is %li\n",hueHue);
+
+  return true;  // captured on,bri,hue
 }
 
 #endif // _HUE_H_
\ No newline at end of file
@@ -9,16 +9,79 @@
  */
 
 #include "application.h"
-
-TCPClient WemoClient;
+#include "HttpPool.h"
 
 int wemoPort = 49153;
 const char *wemoIP[6] = {"192.168.1.30","192.168.1.31","192.168.1.32","192.168.1.33","192.168.1.34","192.168.1.35"};
 
+// SOAP requests, built once at compile time with the Content-Length filled in
+// so each command is a single write with nothing built on the heap
+#define WEMO_SOAP_START "<?xml version=\"1.0\" encoding=\"utf-8\"?><s:Envelope xmlns:s=\"http://schemas.xmlsoap.org/soap/envelope/\" s:encodingStyle=\"http://schemas.xmlsoap.org/soap/encoding/\"><s:Body>"
+#define WEMO_SOAP_END "</s:Body></s:Envelope>"
+#define WEMO_SET_BODY(state) WEMO_SOAP_START "<u:SetBinaryState xmlns:u=\"urn:Belkin:service:basicevent:1\"><BinaryState>" state "</BinaryState></u:SetBinaryState>" WEMO_SOAP_END
+#define WEMO_GET_BODY WEMO_SOAP_START "<u:GetBinaryState xmlns:u=\"urn:Belkin:service:basicevent:1\"></u:GetBinaryState>" WEMO_SOAP_END
+
+const size_t WEMO_REQUEST_SIZE = 512;
+
+struct WemoRequest {
+  char data[WEMO_REQUEST_SIZE];
+  size_t length;
+};
+
+constexpr size_t wemoAppend(char *out, size_t pos, const char *text) {
+  while (*text) {
+    out[pos++] = *text++;
+  }
+  return pos;
+}
+
+constexpr size_t wemoAppendNumber(char *out, size_t pos, size_t value) {
+  char digits[10] = {};
+  int count = 0;
+
+  do {
+    digits[count++] = '0' + (value % 10);
+    value /= 10;
+  } while (value);
+  while (count) {
+    out[pos++] = digits[--count];
+  }
+  return pos;
+}
+
+// a request that doesn't fit runs off the end of data and fails to compile
+constexpr WemoRequest wemoBuildRequest(const char *action, const char *body) {
+  WemoRequest request {};
+  size_t pos = 0;
+  size_t bodyLength = 0;
+
+  while (body[bodyLength]) {
+    bodyLength++;
+  }
+  pos = wemoAppend(request.data,pos,"POST /upnp/control/basicevent1 HTTP/1.1\r\n");
+  pos = wemoAppend(request.data,pos,"Content-Type: text/xml; charset=utf-8\r\n");
+  pos = wemoAppend(request.data,pos,"SOAPACTION: \"urn:Belkin:service:basicevent:1#");
+  pos = wemoAppend(request.data,pos,action);
+  pos = wemoAppend(request.data,pos,"\"\r\n");
+  pos = wemoAppend(request.data,pos,"Connection: keep-alive\r\n");
+  pos = wemoAppend(request.data,pos,"Content-Length: ");
+  pos = wemoAppendNumber(request.data,pos,bodyLength);
+  pos = wemoAppend(request.data,pos,"\r\n\r\n");
+  pos = wemoAppend(request.data,pos,body);
+  request.length = pos;
+  return request;
+}
+
+constexpr WemoRequest wemoRequestOn = wemoBuildRequest("SetBinaryState",WEMO_SET_BODY("1"));
+constexpr WemoRequest wemoRequestOff = wemoBuildRequest("SetBinaryState",WEMO_SET_BODY("0"));
+constexpr WemoRequest wemoRequestState = wemoBuildRequest("GetBinaryState",WEMO_GET_BODY);
+
 // Function Prototypes
 void switchON(int wemo);
 void switchOFF(int wemo);
 void wemoWrite(int outlet, bool wemoState);
+bool wemoSend(int outlet, bool wemoState, HttpPool &pool=httpPool);
+int wemoRead(int wemo);
 
 // Turn on/off wemo outlets similar to digitalWrite
 void wemoWrite(int outlet, bool wemoState) {
@@ -30,53 +93,36 @@ void wemoWrite(int outlet, bool wemoState) {
   }
 }
 
+// send the SetBinaryState request, returns false if it didn't all go out
+bool wemoSend(int outlet, bool wemoState, HttpPool &pool) {
+  const WemoRequest &request = wemoState ? wemoRequestOn : wemoRequestOff;
 
+  return pool.send(wemoIP[outlet],wemoPort,(const uint8_t *)request.data,request.length) != NULL;
+}
+
+// ask an outlet if it is on, returns 1 for on, 0 for off, -1 if it didn't answer
+int wemoRead(int wemo) {
+  TCPClient *WemoClient = httpPool.send(wemoIP[wemo],wemoPort,(const uint8_t *)wemoRequestState.data,wemoRequestState.length);
+  if (!WemoClient) {
+    return -1;
+  }
+  if (!WemoClient->find("<BinaryState>")) {
+    return -1;
+  }
+  return (WemoClient->read() == '1') ? 1 : 0;
+}
 
 // turn on specified wemo outlet
+// connections to the outlets are kept open and reused, see HttpPool.h
 void switchON(int wemo) {
-  
-  String data1;
-  
   Serial.printf("Switching On Wemo #%i\n",wemo);
-  data1+="<?xml version=\"1.0\" encoding=\"utf-8\"?><s:Envelope xmlns:s=\"http://schemas.xmlsoap.org/soap/envelope/\" s:encodingStyle=\"http://schemas.xmlsoap.org/soap/encoding/\"><s:Body><u:SetBinaryState xmlns:u=\"urn:Belkin:service:basicevent:1\"><BinaryState>1</BinaryState></u:SetBinaryState></s:Body></s:Envelope>"; // Use HTML encoding for comma's
-  if (WemoClient.connect(wemoIP[wemo],wemoPort)) {
-        WemoClient.println("POST /upnp/control/basicevent1 HTTP/1.1");
-        WemoClient.println("Content-Type: text/xml; charset=utf-8");
-        WemoClient.println("SOAPACTION: \"urn:Belkin:service:basicevent:1#SetBinaryState\"");
-        WemoClient.println("Connection: keep-alive");
-        WemoClient.print("Content-Length: ");
-        WemoClient.println(data1.length());
-        WemoClient.println();
-        WemoClient.print(data1);
-        WemoClient.println();
-    }
-
-  if (WemoClient.connected()) {
-     WemoClient.stop();
-  }
+  wemoSend(wemo,true);
 }
 
 // turn off wemo outlet specified
 void switchOFF(int wemo){
-  String data1;
-  
   Serial.printf("Switching Off Wemo #%i \n",wemo);
-  data1+="<?xml version=\"1.0\" encoding=\"utf-8\"?><s:Envelope xmlns:s=\"http://schemas.xmlsoap.org/soap/envelope/\" s:encodingStyle=\"http://schemas.xmlsoap.org/soap/encoding/\"><s:Body><u:SetBinaryState xmlns:u=\"urn:Belkin:service:basicevent:1\"><BinaryState>0</BinaryState></u:SetBinaryState></s:Body></s:Envelope>"; // Use HTML encoding for comma's
-  if (WemoClient.connect(wemoIP[wemo],wemoPort)) {
-        WemoClient.println("POST /upnp/control/basicevent1 HTTP/1.1");
-        WemoClient.println("Content-Type: text/xml; charset=utf-8");
-        WemoClient.println("SOAPACTION: \"urn:Belkin:service:basicevent:1#SetBinaryState\"");
-        WemoClient.println("Connection: keep-alive");
-        WemoClient.print("Content-Length: ");
-        WemoClient.println(data1.length());
-        WemoClient.println();
-        WemoClient.print(data1);
-        WemoClient.println();
-    }
-   
-  if (WemoClient.connected()) {
-     WemoClient.stop();
-  }
+  wemoSend(wemo,false);
 }
 
 #endif // _WEMO_H_
\ No newline at end of file
@@ -85,14 +85,14 @@
 
 #if (PLATFORM_ID == 32)
 Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, SPIClass& spi, uint8_t t) :
-  begun(false), type(t), brightness(0), pixels(NULL), endTime(0)
+  begun(false), gammaOn(false), type(t), brightness(0), pixels(NULL), scaled(NULL), endTime(0)
 {
   updateLength(n);
   spi_ = &spi;
 }
 #else
 Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, uint8_t p, uint8_t t) :
-  begun(false), type(t), brightness(0), pixels(NULL), endTime(0)
+  begun(false), gammaOn(false), type(t), brightness(0), pixels(NULL), scaled(NULL), endTime(0)
 {
   updateLength(n);
   setPin(p);
@@ -102,6 +102,7 @@ Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, uint8_t p, uint8_t t) :
 
 Adafruit_NeoPixel::~Adafruit_NeoPixel() {
   if (pixels) free(pixels);
+  if (scaled) free(scaled);
 #if (PLATFORM_ID == 32)
   spi_->end();
 #else
@@ -119,6 +120,8 @@ uint8_t Adafruit_NeoPixel::getType() const {
 
 void Adafruit_NeoPixel::updateLength(uint16_t n) {
   if (pixels) free(pixels); // Free existing data (if any)
+  if (scaled) free(scaled); // Output copy is remade at the new size by show()
+  scaled = NULL;
 
   // Allocate new data -- note: ALL PIXELS ARE CLEARED
   numBytes = n * ((type == SK6812RGBW) ? 4 : 3);
@@ -220,6 +223,10 @@ void Adafruit_NeoPixel::show(void) {
         wait_time = 50L;
       } break;
   }
+  // Brightness and gamma are applied here, while the latch time runs out,
+  // because the bit banging below has no spare cycles to do it per bit.
+  uint8_t *data = scaledPixels();
+  if(!data) return;
   while((micros() - endTime) < wait_time);
   // endTime is a private member (rather than global var) so that multiple
   // instances on different pins can be quickly issued in succession (each
@@ -235,7 +242,7 @@ void Adafruit_NeoPixel::show(void) {
   volatile uint16_t i = numBytes; // Output loop counter
   volatile uint8_t
     j,              // 8-bit inner loop counter
-   *ptr = pixels,   // Pointer to next byte
+   *ptr = data,     // Pointer to next byte
     g,              // Current green byte value
     r,              // Current red byte value
     b,              // Current blue byte value
@@ -903,12 +910,13 @@ void Adafruit_NeoPixel::show(void) {
   }
 
   memset(spiArray, 0, spiArraySize);
-  // expand pixel data and pack into spi buffer
+  // expand pixel data and pack into spi buffer, scaling each byte on the way
   for (int x = 0; x < numPixels(); x++) {
     for (int s = 0; s < 3; s++) {
-      spiArray[(x*9)+(s*3)+0+resetOff] = ((0x80 & pixels[(x*3)+s])?(PIX_HI << 5):(PIX_LO << 5)) + ((0x40 & pixels[(x*3)+s])?(PIX_HI << 2):(PIX_LO << 2)) + ((0x20 & pixels[(x*3)+s])?(0b11):(0b10));
-      spiArray[(x*9)+(s*3)+1+resetOff] = 0 /* bit 7 always 0 */ + ((0x10 & pixels[(x*3)+s])?(PIX_HI << 4):(PIX_LO << 4)) + ((0x08 & pixels[(x*3)+s])?(PIX_HI << 1):(PIX_LO << 1)) + 1 /* bit 0 always 1 */;
-      spiArray[(x*9)+(s*3)+2+resetOff] = ((0x04 & pixels[(x*3)+s])?(0b10 << 6):(0b00 << 6)) + ((0x02 & pixels[(x*3)+s])?(PIX_HI << 3):(PIX_LO << 3)) + ((0x01 & pixels[(x*3)+s])?(PIX_HI):(PIX_LO));
+      uint8_t c = scale(pixels[(x*3)+s]);
+      spiArray[(x*9)+(s*3)+0+resetOff] = ((0x80 & c)?(PIX_HI << 5):(PIX_LO << 5)) + ((0x40 & c)?(PIX_HI << 2):(PIX_LO << 2)) + ((0x20 & c)?(0b11):(0b10));
+      spiArray[(x*9)+(s*3)+1+resetOff] = 0 /* bit 7 always 0 */ + ((0x10 & c)?(PIX_HI << 4):(PIX_LO << 4)) + ((0x08 & c)?(PIX_HI << 1):(PIX_LO << 1)) + 1 /* bit 0 always 1 */;
+      spiArray[(x*9)+(s*3)+2+resetOff] = ((0x04 & c)?(0b10 << 6):(0b00 << 6)) + ((0x02 & c)?(PIX_HI << 3):(PIX_LO << 3)) + ((0x01 & c)?(PIX_HI):(PIX_LO));
     }
   }
 
@@ -1020,7 +1028,7 @@ void Adafruit_NeoPixel::show(void) {
     uint16_t pos = 0; // bit position
 
     for(uint16_t n=0; n<numBytes; n++) {
-      uint8_t pix = pixels[n];
+      uint8_t pix = data[n];
 
       for(uint8_t mask=0x80, i=0; mask>0; mask >>= 1, i++) {
         #ifdef NEO_KHZ400
@@ -1158,7 +1166,7 @@ void Adafruit_NeoPixel::show(void) {
 
     // Tries to re-send the frame if is interrupted by the SoftDevice.
     while(1) {
-      uint8_t *p = pixels;
+      uint8_t *p = data;
 
       uint32_t cycStart = DWT->CYCCNT;
       uint32_t cyc = 0;
@@ -1212,11 +1220,6 @@ void Adafruit_NeoPixel::show(void) {
 void Adafruit_NeoPixel::setPixelColor(
   uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
   if(n < numLEDs) {
-    if(brightness) { // See notes in setBrightness()
-      r = (r * brightness) >> 8;
-      g = (g * brightness) >> 8;
-      b = (b * brightness) >> 8;
-    }
     uint8_t *p = &pixels[n * 3];
     switch(type) {
       case WS2812B: // WS2812, WS2812B & WS2813 is GRB order.
@@ -1248,12 +1251,6 @@ void Adafruit_NeoPixel::setPixelColor(
 void Adafruit_NeoPixel::setPixelColor(
   uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
   if(n < numLEDs) {
-    if(brightness) { // See notes in setBrightness()
-      r = (r * brightness) >> 8;
-      g = (g * brightness) >> 8;
-      b = (b * brightness) >> 8;
-      w = (w * brightness) >> 8;
-    }
     uint8_t *p = &pixels[n * (type==SK6812RGBW?4:3)];
     switch(type) {
       case WS2812B: // WS2812, WS2812B & WS2813 is GRB order.
@@ -1295,11 +1292,6 @@ void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint32_t c) {
       r = (uint8_t)(c >> 16),
       g = (uint8_t)(c >>  8),
       b = (uint8_t)c;
-    if(brightness) { // See notes in setBrightness()
-      r = (r * brightness) >> 8;
-      g = (g * brightness) >> 8;
-      b = (b * brightness) >> 8;
-    }
     uint8_t *p = &pixels[n * (type==SK6812RGBW?4:3)];
     switch(type) {
       case WS2812B: // WS2812, WS2812B & WS2813 is GRB order.
@@ -1321,7 +1313,7 @@ void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint32_t c) {
           *p++ = r;
           *p++ = g;
           *p++ = b;
-          *p = brightness ? ((w * brightness) >> 8) : w;
+          *p = w;
         } break;
       case WS2811: // WS2811 is RGB order
       case TM1803: // TM1803 is RGB order
@@ -1407,19 +1399,8 @@ uint32_t Adafruit_NeoPixel::getPixelColor(uint16_t n) const {
       } break;
   }
 
-  // Adjust this back up to the true color, as setting a pixel color will
-  // scale it back down again.
-  if(brightness) { // See notes in setBrightness()
-    //Cast the color to a byte array
-    uint8_t * c_ptr =reinterpret_cast<uint8_t*>(&c);
-    if (type == SK6812RGBW) {
-      c_ptr[3] = (c_ptr[3] << 8)/brightness;
-    }
-    c_ptr[0] = (c_ptr[0] << 8)/brightness;
-    c_ptr[1] = (c_ptr[1] << 8)/brightness;
-    c_ptr[2] = (c_ptr[2] << 8)/brightness;
-  }
-  return c; // Pixel # is out of bounds
+  // Stored colors are never scaled, so this is exactly what was set.
+  return c;
 }
 
 uint8_t *Adafruit_NeoPixel::getPixels(void) const {
@@ -1436,16 +1417,9 @@ uint16_t Adafruit_NeoPixel::getNumLeds(void) const {
 
 // Adjust output brightness; 0=darkest (off), 255=brightest.  This does
 // NOT immediately affect what's currently displayed on the LEDs.  The
-// next call to show() will refresh the LEDs at this level.  However,
-// this process is potentially "lossy," especially when increasing
-// brightness.  The tight timing in the WS2811/WS2812 code means there
-// aren't enough free cycles to perform this scaling on the fly as data
-// is issued.  So we make a pass through the existing color data in RAM
-// and scale it (subsequent graphics commands also work at this
-// brightness level).  If there's a significant step up in brightness,
-// the limited number of steps (quantization) in the old data will be
-// quite visible in the re-scaled version.  For a non-destructive
-// change, you'll need to re-render the full strip data.  C'est la vie.
+// next call to show() will refresh the LEDs at this level.  The colors
+// in RAM are kept as they were set and only scaled on their way out in
+// show(), so changing the brightness is cheap and never loses color.
 void Adafruit_NeoPixel::setBrightness(uint8_t b) {
   // Stored brightness value is different than what's passed.
   // This simplifies the actual scaling math later, allowing a fast
@@ -1453,22 +1427,7 @@ void Adafruit_NeoPixel::setBrightness(uint8_t b) {
   // adding 1 here may (intentionally) roll over...so 0 = max brightness
   // (color values are interpreted literally; no scaling), 1 = min
   // brightness (off), 255 = just below max brightness.
-  uint8_t newBrightness = b + 1;
-  if(newBrightness != brightness) { // Compare against prior value
-    // Brightness has changed -- re-scale existing data in RAM
-    uint8_t  c,
-            *ptr           = pixels,
-             oldBrightness = brightness - 1; // De-wrap old brightness value
-    uint16_t scale;
-    if(oldBrightness == 0) scale = 0; // Avoid /0
-    else if(b == 255) scale = 65535 / oldBrightness;
-    else scale = (((uint16_t)newBrightness << 8) - 1) / oldBrightness;
-    for(uint16_t i=0; i<numBytes; i++) {
-      c      = *ptr;
-      *ptr++ = (c * scale) >> 8;
-    }
-    brightness = newBrightness;
-  }
+  brightness = b + 1;
 }
 
 //Return the brightness value
@@ -1476,6 +1435,57 @@ uint8_t Adafruit_NeoPixel::getBrightness(void) const {
   return brightness - 1;
 }
 
+// Gamma correct colors in show() so brightness steps look even to the eye.
+// Like brightness, the colors in RAM are left alone.
+void Adafruit_NeoPixel::setGamma(bool g) {
+  gammaOn = g;
+}
+
+bool Adafruit_NeoPixel::getGamma(void) const {
+  return gammaOn;
+}
+
+// Gamma 2.6 correction table
+static const uint8_t gammaTable[256] = {
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  1,  1,  1,  1,  1,  1,  1,  1,
+    1,  1,  1,  1,  2,  2,  2,  2,  2,  2,  2,  2,  3,  3,  3,  3,
+    3,  3,  4,  4,  4,  4,  5,  5,  5,  5,  5,  6,  6,  6,  6,  7,
+    7,  7,  8,  8,  8,  9,  9,  9, 10, 10, 10, 11, 11, 11, 12, 12,
+   13, 13, 13, 14, 14, 15, 15, 16, 16, 17, 17, 18, 18, 19, 19, 20,
+   20, 21, 21, 22, 22, 23, 24, 24, 25, 25, 26, 27, 27, 28, 29, 29,
+   30, 31, 31, 32, 33, 34, 34, 35, 36, 37, 38, 38, 39, 40, 41, 42,
+   42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57,
+   58, 59, 60, 61, 62, 63, 64, 65, 66, 68, 69, 70, 71, 72, 73, 75,
+   76, 77, 78, 80, 81, 82, 84, 85, 86, 88, 89, 90, 92, 93, 94, 96,
+   97, 99,100,102,103,105,106,108,109,111,112,114,115,117,119,120,
+  122,124,125,127,129,130,132,134,136,137,139,141,143,145,146,148,
+  150,152,154,156,158,160,162,164,166,168,170,172,174,176,178,180,
+  182,184,186,188,191,193,195,197,199,202,204,206,209,211,213,215,
+  218,220,223,225,227,230,232,235,237,240,242,245,247,250,252,255};
+
+uint8_t Adafruit_NeoPixel::gamma8(uint8_t x) {
+  return gammaTable[x];
+}
+
+// One color byte as it goes out on the wire, gamma then brightness
+inline uint8_t Adafruit_NeoPixel::scale(uint8_t c) const {
+  if(gammaOn) c = gammaTable[c];
+  return brightness ? (c * brightness) >> 8 : c;
+}
+
+// The pixel data with brightness and gamma applied, for the platforms that
+// send straight out of a buffer.  When there is nothing to apply the stored
+// data goes out as is.
+uint8_t *Adafruit_NeoPixel::scaledPixels(void) {
+  if(!brightness && !gammaOn) return pixels;
+  if(!scaled && !(scaled = (uint8_t *)malloc(numBytes))) return NULL;
+  for(uint16_t i=0; i<numBytes; i++) {
+    scaled[i] = scale(pixels[i]);
+  }
+  return scaled;
+}
+
 void Adafruit_NeoPixel::clear(void) {
   memset(pixels, 0, numBytes);
 }
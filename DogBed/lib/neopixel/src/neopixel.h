@@ -88,6 +88,7 @@ class Adafruit_NeoPixel {
     setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w),
     setPixelColor(uint16_t n, uint32_t c),
     setBrightness(uint8_t),
+    setGamma(bool g),
     setColor(uint16_t aLedNumber, byte aRed, byte aGreen, byte aBlue),
     setColor(uint16_t aLedNumber, byte aRed, byte aGreen, byte aBlue, byte aWhite),
     setColorScaled(uint16_t aLedNumber, byte aRed, byte aGreen, byte aBlue, byte aScaling),
@@ -96,6 +97,8 @@ class Adafruit_NeoPixel {
     setColorDimmed(uint16_t aLedNumber, byte aRed, byte aGreen, byte aBlue, byte aWhite, byte aBrightness),
     updateLength(uint16_t n),
     clear(void);
+  bool
+    getGamma(void) const;
   uint8_t
    *getPixels() const,
     getBrightness(void) const,
@@ -104,6 +107,8 @@ class Adafruit_NeoPixel {
   uint16_t
     numPixels(void) const,
     getNumLeds(void) const;
+  static uint8_t
+    gamma8(uint8_t x);
   static uint32_t
     Color(uint8_t r, uint8_t g, uint8_t b),
     Color(uint8_t r, uint8_t g, uint8_t b, uint8_t w);
@@ -115,7 +120,8 @@ class Adafruit_NeoPixel {
  private:
 
   bool
-    begun;         // true if begin() previously called
+    begun,         // true if begin() previously called
+    gammaOn;       // true to gamma correct colors in show()
   uint16_t
     numLEDs,       // Number of RGB LEDs in strip
     numBytes;      // Size of 'pixels' buffer below
@@ -124,9 +130,14 @@ class Adafruit_NeoPixel {
   uint8_t
     pin,           // Output pin number
     brightness,
-   *pixels;        // Holds LED color values (3 bytes each)
+   *pixels,        // Holds LED color values (3 bytes each), never scaled
+   *scaled;        // Brightness scaled copy of 'pixels' sent by show()
   uint32_t
     endTime;       // Latch timing reference
+
+  uint8_t
+    scale(uint8_t c) const,
+   *scaledPixels(void);
 #if (PLATFORM_ID == 32)
   SPIClass*
     spi_;
@@ -0,0 +1,127 @@
+#ifndef _BME280SAMPLER_H_
+#define _BME280SAMPLER_H_
+
+/*
+ *  Project: DogBed
+ *  Description: Runs the BME280 in normal mode and keeps its samples in a
+ *               timestamped ring buffer, so anything that wants a reading
+ *               gets it from memory instead of the bus
+ *  Author: David Barbour
+ */
+
+#include "Particle.h"
+#include "Adafruit_BME280.h"
+
+/* Usage:
+ * BME280Sampler sampler(bme);
+ * sampler.begin(...);                 // after bme.begin()
+ * sampler.poll();                     // often, only reads the bus when a sample is due
+ *
+ * each reader keeps its own cursor and gets every sample once:
+ * static unsigned int cursor;
+ * BME280Sampler::Sample sample;
+ * while (sampler.next(cursor,sample)) { ... }
+ */
+
+class BME280Sampler {
+
+  static const unsigned int CAPACITY = 16;   // power of 2 so the cursor can wrap
+
+  public:
+    struct Sample {
+      unsigned int time;                     // millis() when it was read
+      Adafruit_BME280::Measurement value;
+    };
+
+  private:
+    Adafruit_BME280 &_bme;
+    Sample _samples[CAPACITY];
+    unsigned int _written;                   // samples ever written, the next one goes at _written % CAPACITY
+    unsigned int _cycle;                     // us between samples, measuring + standby
+    unsigned int _lastSample;                // micros() of the last read
+
+  public:
+    BME280Sampler(Adafruit_BME280 &bme) : _bme(bme) {
+      _written = 0;
+      _cycle = 0;
+      _lastSample = 0;
+    }
+
+    // put the sensor in normal mode, it measures once every measurement time + standby
+    void begin(Adafruit_BME280::sensor_sampling tempSampling,
+               Adafruit_BME280::sensor_sampling pressSampling,
+               Adafruit_BME280::sensor_sampling humSampling,
+               Adafruit_BME280::sensor_filter filter,
+               Adafruit_BME280::standby_duration standby) {
+      _bme.setSampling(Adafruit_BME280::MODE_NORMAL,tempSampling,pressSampling,humSampling,filter,standby);
+      _cycle = _bme.measurementTime() + standbyMicros(standby);
+      _lastSample = micros();
+    }
+
+    // read a sample if the sensor has made a new one since the last, returns true if it did
+    bool poll() {
+      unsigned int now = micros();
+      Sample *sample;
+
+      if (_cycle == 0 || now - _lastSample < _cycle) {
+        return false;
+      }
+      _lastSample = now;
+      sample = &_samples[_written % CAPACITY];
+      sample->time = millis();
+      // the display may be flushing on its own thread, share the bus a read at a time
+      WITH_LOCK(Wire) {
+        sample->value = _bme.readAll();
+      }
+      _written++;
+      return true;
+    }
+
+    // the next sample after cursor, returns false if the reader has seen them all.
+    // A reader that fell more than CAPACITY behind skips to the oldest one kept
+    bool next(unsigned int &cursor, Sample &sample) {
+      if (cursor == _written) {
+        return false;
+      }
+      if (_written - cursor > CAPACITY) {
+        cursor = _written - CAPACITY;
+      }
+      sample = _samples[cursor % CAPACITY];
+      cursor++;
+      return true;
+    }
+
+    // the newest sample, returns false if there isn't one yet
+    bool latest(Sample &sample) {
+      if (_written == 0) {
+        return false;
+      }
+      sample = _samples[(_written - 1) % CAPACITY];
+      return true;
+    }
+
+    unsigned int count() {
+      return _written < CAPACITY ? _written : CAPACITY;
+    }
+
+    unsigned int written() {
+      return _written;
+    }
+
+  private:
+    static unsigned int standbyMicros(Adafruit_BME280::standby_duration standby) {
+      switch (standby) {
+        case Adafruit_BME280::STANDBY_MS_0_5:  return 500;
+        case Adafruit_BME280::STANDBY_MS_10:   return 10000;
+        case Adafruit_BME280::STANDBY_MS_20:   return 20000;
+        case Adafruit_BME280::STANDBY_MS_62_5: return 62500;
+        case Adafruit_BME280::STANDBY_MS_125:  return 125000;
+        case Adafruit_BME280::STANDBY_MS_250:  return 250000;
+        case Adafruit_BME280::STANDBY_MS_500:  return 500000;
+        case Adafruit_BME280::STANDBY_MS_1000: return 1000000;
+      }
+      return 0;
+    }
+};
+
+#endif // _BME280SAMPLER_H_
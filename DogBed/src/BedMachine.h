@@ -0,0 +1,139 @@
+#ifndef _BEDMACHINE_H_
+#define _BEDMACHINE_H_
+
+/*
+ *  Project: DogBed
+ *  Description: The bed's states, events and transition table. DogBed.cpp
+ *               defines the actions, the host tests define their own so a
+ *               scripted stream of events can be run through the same table
+ *  Author: David Barbour
+ */
+
+#include "Particle.h"
+#include "StateMachine.h"
+
+//state entry, exit and transition actions
+void enterOff();
+void enterSetupOnOff();
+void enterSetupCool();
+void enterSetupHeat();
+void enterSetupManual();
+void enterWaitCool();
+void enterWaitHeat();
+void enterCooling();
+void enterHeating();
+void exitCooling();
+void exitHeating();
+void waitCountdown();
+void stopCountdown();
+void raiseCoolingTemp();
+void lowerCoolingTemp();
+void raiseHeatingTemp();
+void lowerHeatingTemp();
+
+//There are multiple states the application can be in,
+//each setup screen and the forced heat/cool modes are their own state
+enum BedState {
+    STATE_OFF,
+    STATE_SETUP_ONOFF,
+    STATE_SETUP_COOL,
+    STATE_SETUP_HEAT,
+    STATE_SETUP_MANUAL,
+    STATE_WAIT_COOL,
+    STATE_COOLING,
+    STATE_WAIT_HEAT,
+    STATE_HEATING,
+    STATE_FORCE_COOL,
+    STATE_FORCE_HEAT,
+    STATE_COUNT
+};
+
+//joystick events fire when the stick is pushed (and repeat while up/down is held),
+//temperature events are what the thermostat decided
+enum BedEvent {
+    EVT_UP,
+    EVT_DOWN,
+    EVT_LEFT,
+    EVT_RIGHT,
+    EVT_BUTTON,
+    EVT_HOT_IDLE,       //needs cooling, fan stays off
+    EVT_HOT_MOTION,     //needs cooling, fan runs
+    EVT_COLD_IDLE,      //needs heating, heater stays off
+    EVT_COLD_MOTION,    //needs heating, heater runs
+    EVT_COMFORT,        //the temperature is where it should be
+    EVT_COUNT
+};
+const int EVT_NONE = -1;
+
+constexpr MachineState bedStates[STATE_COUNT] = {
+    //entry             exit            during
+    {enterOff,          NULL,           NULL},              //STATE_OFF
+    {enterSetupOnOff,   NULL,           NULL},              //STATE_SETUP_ONOFF
+    {enterSetupCool,    NULL,           NULL},              //STATE_SETUP_COOL
+    {enterSetupHeat,    NULL,           NULL},              //STATE_SETUP_HEAT
+    {enterSetupManual,  NULL,           NULL},              //STATE_SETUP_MANUAL
+    {enterWaitCool,     stopCountdown,  waitCountdown},     //STATE_WAIT_COOL
+    {enterCooling,      exitCooling,    NULL},              //STATE_COOLING
+    {enterWaitHeat,     stopCountdown,  waitCountdown},     //STATE_WAIT_HEAT
+    {enterHeating,      exitHeating,    NULL},              //STATE_HEATING
+    {enterCooling,      exitCooling,    NULL},              //STATE_FORCE_COOL
+    {enterHeating,      exitHeating,    NULL}               //STATE_FORCE_HEAT
+};
+
+constexpr Transition bedTransitions[] = {
+    //from                  event               to                  action
+    {STATE_OFF,             EVT_BUTTON,         STATE_SETUP_ONOFF,  NULL},
+
+    //on off screen, up turns it on, down turns it off
+    {STATE_SETUP_ONOFF,     EVT_UP,             STATE_WAIT_COOL,    NULL},
+    {STATE_SETUP_ONOFF,     EVT_DOWN,           STATE_OFF,          NULL},
+    {STATE_SETUP_ONOFF,     EVT_RIGHT,          STATE_SETUP_COOL,   NULL},
+
+    //cooling temperature screen
+    {STATE_SETUP_COOL,      EVT_UP,             STATE_SETUP_COOL,   raiseCoolingTemp},
+    {STATE_SETUP_COOL,      EVT_DOWN,           STATE_SETUP_COOL,   lowerCoolingTemp},
+    {STATE_SETUP_COOL,      EVT_LEFT,           STATE_SETUP_ONOFF,  NULL},
+    {STATE_SETUP_COOL,      EVT_RIGHT,          STATE_SETUP_HEAT,   NULL},
+
+    //heating temperature screen
+    {STATE_SETUP_HEAT,      EVT_UP,             STATE_SETUP_HEAT,   raiseHeatingTemp},
+    {STATE_SETUP_HEAT,      EVT_DOWN,           STATE_SETUP_HEAT,   lowerHeatingTemp},
+    {STATE_SETUP_HEAT,      EVT_LEFT,           STATE_SETUP_COOL,   NULL},
+    {STATE_SETUP_HEAT,      EVT_RIGHT,          STATE_SETUP_MANUAL, NULL},
+
+    //manual heat or cool screen
+    {STATE_SETUP_MANUAL,    EVT_UP,             STATE_FORCE_HEAT,   NULL},
+    {STATE_SETUP_MANUAL,    EVT_DOWN,           STATE_FORCE_COOL,   NULL},
+    {STATE_SETUP_MANUAL,    EVT_LEFT,           STATE_SETUP_HEAT,   NULL},
+
+    //running, follow the temperature and the motion sensor
+    {STATE_WAIT_COOL,       EVT_HOT_MOTION,     STATE_COOLING,      NULL},
+    {STATE_WAIT_COOL,       EVT_COLD_IDLE,      STATE_WAIT_HEAT,    NULL},
+    {STATE_WAIT_COOL,       EVT_COLD_MOTION,    STATE_HEATING,      NULL},
+    {STATE_WAIT_COOL,       EVT_LEFT,           STATE_SETUP_ONOFF,  NULL},
+
+    {STATE_COOLING,         EVT_HOT_IDLE,       STATE_WAIT_COOL,    NULL},
+    {STATE_COOLING,         EVT_COLD_IDLE,      STATE_WAIT_HEAT,    NULL},
+    {STATE_COOLING,         EVT_COLD_MOTION,    STATE_HEATING,      NULL},
+    {STATE_COOLING,         EVT_COMFORT,        STATE_WAIT_COOL,    NULL},
+    {STATE_COOLING,         EVT_LEFT,           STATE_SETUP_ONOFF,  NULL},
+
+    {STATE_WAIT_HEAT,       EVT_COLD_MOTION,    STATE_HEATING,      NULL},
+    {STATE_WAIT_HEAT,       EVT_HOT_IDLE,       STATE_WAIT_COOL,    NULL},
+    {STATE_WAIT_HEAT,       EVT_HOT_MOTION,     STATE_COOLING,      NULL},
+    {STATE_WAIT_HEAT,       EVT_LEFT,           STATE_SETUP_ONOFF,  NULL},
+
+    {STATE_HEATING,         EVT_COLD_IDLE,      STATE_WAIT_HEAT,    NULL},
+    {STATE_HEATING,         EVT_HOT_IDLE,       STATE_WAIT_COOL,    NULL},
+    {STATE_HEATING,         EVT_HOT_MOTION,     STATE_COOLING,      NULL},
+    {STATE_HEATING,         EVT_COMFORT,        STATE_WAIT_HEAT,    NULL},
+    {STATE_HEATING,         EVT_LEFT,           STATE_SETUP_ONOFF,  NULL},
+
+    //forced modes ignore the temperature until you leave them
+    {STATE_FORCE_COOL,      EVT_LEFT,           STATE_SETUP_ONOFF,  NULL},
+    {STATE_FORCE_HEAT,      EVT_LEFT,           STATE_SETUP_ONOFF,  NULL}
+};
+
+constexpr auto bedDispatch = buildDispatchIndex<STATE_COUNT,EVT_COUNT>(bedTransitions);
+
+#endif // _BEDMACHINE_H_
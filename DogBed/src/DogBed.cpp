@@ -8,76 +8,152 @@
 #include "IoTClassroom_CNM.h"
 #include "neopixel.h"
 #include "Colors.h"
-#include "math.h"
-#include "IoTTimer.h"
 #include "Adafruit_GFX.h"
 #include "Adafruit_SSD1306.h"
 #include "Adafruit_BME280.h"
 #include "Graphic.h"
 #include "Button.h"
 #include "wemo.h"
+#include "WemoQueue.h"
+#include "LoopProfiler.h"
+#include "TaskScheduler.h"
+#include "StateMachine.h"
+#include "PixelAnimator.h"
+#include "BME280Sampler.h"
+#include "ThermostatControl.h"
+#include "MotionSensor.h"
+#include "TimerWheel.h"
+#include "ScreenCache.h"
+#include "BedMachine.h"
 
 //joystick setup
 const int joyHorz = A1;
 const int joyVert = A2;
 const int joySwitch = D6;
 Button joyButton(joySwitch,true);
-int newVer;int newHor;
-int oldVer;int oldHor;
+Joystick joystick(joyHorz,joyVert);
 
 //temperature setup
 Adafruit_BME280 bme;
+BME280Sampler sampler(bme);
 bool status;
 
 //neo pixel setup
 const int PIXELCOUNT = 20;
 Adafruit_NeoPixel pixel ( PIXELCOUNT , SPI1 , WS2812B );
+PixelAnimator ring;
+const int BREATHE_LOW = 3;        //breathing goes between these brightnesses
+const int BREATHE_HIGH = 17;
+const int BREATHE_PERIOD = 2500;  //ms for one breath
 
 //display setup
 Adafruit_SSD1306 display(-1);
-bool showDisplay=false;
+bool displayDirty=false;
+
+//the screens that never change are drawn once and copied back after that,
+//only the setpoint and countdown are drawn on top each time
+enum BedScreen {
+    SCREEN_ONOFF,
+    SCREEN_SET_COOL,
+    SCREEN_SET_HEAT,
+    SCREEN_MANUAL,
+    SCREEN_WAIT_COOL,
+    SCREEN_WAIT_HEAT,
+    SCREEN_COOLING,
+    SCREEN_HEATING,
+    SCREEN_COUNT
+};
+const int SCREEN_PAGES = 35;    //pages the screens draw on between them, 8 would be the whole display
+void drawScreen(int screen);
+ScreenCache<SCREEN_COUNT,SCREEN_PAGES> screens(display,drawScreen);
 
 //temperature reading
 const int sensorWaitTime=10;
-float currentTemp;
-IoTTimer waitTimer;
+int32_t currentTemp;              //all temperatures are in 1/100 deg F, 7350 is 73.5F
 int waitedTime=0;
+int countdownTimer=-1;             //the next countdown step on the timer wheel
 
-//Motion detector
+//Motion detector, read by interrupt so short pulses aren't missed
 const int DETECTPIN=D9;
+const unsigned int MOTION_HOLD = 3000;  //counts as motion for this long after the PIR drops
+MotionSensor motion(DETECTPIN);
 bool motionDetected=false;
+unsigned int motionCount=0;
 
-//wemo
+//wemo, writes are queued and sent from their own thread
 int wemoCool=4; 
 int wemoHeat=2; 
-
-//hue light bulb
+WemoQueue outlets;
+
+//thermostat, runs half a degree past the setpoint, and keeps the
+//outlets on/off for a few minutes so they don't chatter
+const int32_t DEADBAND = 50;
+const unsigned int MIN_ON_TIME = 120000;
+const unsigned int MIN_OFF_TIME = 180000;
+const int MAX_COMMANDS = 6;                 //outlet switches allowed...
+const unsigned int COMMAND_WINDOW = 3600000;//...per hour
+HysteresisControl hysteresisControl(DEADBAND,MIN_ON_TIME,MIN_OFF_TIME,MAX_COMMANDS,COMMAND_WINDOW);
+ControlStrategy *thermostat = &hysteresisControl;
+
+//hue light bulb, follows the ring when the hub answered at startup
 const int BULB=3;
-bool sendCmdToHue = true;
+const unsigned int HUE_PERIOD = 1000;   //a breathing ring updates the bulb at most this often
+bool useHue = false;
 
 //debugging button
 Button debugButton(D4,false);
 
+//loop profiling, prints loops/sec, time per subsystem and bus bytes
+const bool profileLoop = false;
+LoopProfiler profiler(10000);
+
+//display benchmark, prints how fast bitmaps, text, screens and frames go once at startup
+const bool benchmarkDisplay = false;
+const int BENCHMARK_RUNS = 100;
+
+//bytes each bus operation moves, used by the profiler
+const int BME_READ_BYTES = 11;         //address+register write, address+8 byte read
+const int PIXEL_SHOW_BYTES = (PIXELCOUNT*3*3) + 240; //3 spi bytes per color byte + reset
+const int WEMO_REQUEST_BYTES = wemoRequestOn.length; //SetBinaryState headers and body
+
+//task rates in ms, each subsystem only runs when it is due
+TaskScheduler scheduler;
+const int SENSOR_PERIOD = 100;   //looks for a new sample, the bus is only read when one is due
+const int INPUT_PERIOD = 10;     //joystick, buttons and the state logic
+const int DISPLAY_PERIOD = 50;   //push the frame buffer if it changed
+const int PIXEL_PERIOD = 20;     //neo pixel animation, 50 frames/sec
+const int OUTLET_PERIOD = 10;    //hands the outlet thread its next request, picks up the last result
+
+//one-shot timers, run from loop() beside the tasks
+TimerWheel timers;
+
 void PixelFill(int startPixel, int endPixel, int theColor);
+void runDisplayBenchmark();
 void setPixelDisplay(int theState);
+void setHueDisplay(int theState);
 void programLogic();
+void readSensors();
+void readInputs();
+void refreshDisplay();
+void updatePixels();
+void updateOutlets();
 void SetHueOnce(int LightNum,bool HueON,int HueColor,int HueBright, int HueSat);
+void updateDisplay();
+void pixelShow();
+void outletWrite(int outlet, bool outletState);
+int joystickEvent();
+int temperatureEvent();
+void countdownStep();
 
-int applicationState=0;
-int prevApplicationState;
-int setupState=0;
-int subSetupState=0;
+//the states, events and transition table are in BedMachine.h
+StateMachine<STATE_COUNT,EVT_COUNT> bedMachine(bedStates,bedTransitions,bedDispatch);
 
-bool forceHeat = false;
-bool forceCool = false;
+//which neo pixel display goes with each state
+const int statePixels[STATE_COUNT] = {0,1,1,1,1,2,3,4,5,3,5};
 
-bool setVertDown = false;
-bool setVertUp = false;
-bool setHorRight = false;
-bool setHorLeft = false;
-
-float coolingTemp = 74;
-float heatingTemp = 73;
+int32_t coolingTemp = 7400;
+int32_t heatingTemp = 7300;
+const int32_t TEMP_STEP = 100;    //one degree per joystick push
 
 SYSTEM_MODE(MANUAL);
 
@@ -96,11 +172,15 @@ void setup() {
         delay(50);
         Serial.printf(".");}
 
+    //the bulb only follows the ring if the hub is there
+    useHue = getHue(BULB);
+    Serial.printf("Hue hub %s\n",useHue ? "found" : "not answering, bulb not used");
+
     //start the display
     display.begin(SSD1306_SWITCHCAPVCC, 0x3C);
     display.clearDisplay();
     display.display();
-    showDisplay=true;
+    if (benchmarkDisplay) {runDisplayBenchmark();}
 
     //start the neo pixels
     pixel.begin();
@@ -109,637 +189,433 @@ void setup() {
     pixel.show();
 
     //set up motion detector
-    pinMode(DETECTPIN,INPUT);
+    motion.begin();
+
+    //joystick samples on its own timer, holding up or down steps the setpoints
+    joystick.setRepeat(500,150);
+    joystick.begin();
+
+    //buttons queue their clicks by interrupt so none are missed
+    joyButton.begin();
+    debugButton.begin();
 
     //start bme temp guage
     status=bme.begin (0x76);
     if (status==false ) {
         Serial.printf (" BME280 at address %c failed to start ", 0x76 );}
+    //only the temperature is used, the sensor makes one sample a second on its own
+    sampler.begin(Adafruit_BME280::SAMPLING_X1,
+                  Adafruit_BME280::SAMPLING_NONE,
+                  Adafruit_BME280::SAMPLING_NONE,
+                  Adafruit_BME280::FILTER_X2,
+                  Adafruit_BME280::STANDBY_MS_1000);
+
+    //start the tasks and the timers
+    timers.begin();
+    scheduler.addTask(readSensors,SENSOR_PERIOD);
+    scheduler.addTask(readInputs,INPUT_PERIOD);
+    scheduler.addTask(refreshDisplay,DISPLAY_PERIOD);
+    scheduler.addTask(updatePixels,PIXEL_PERIOD);
+    scheduler.addTask(updateOutlets,OUTLET_PERIOD);
+
+    //start out off, this also makes sure the heater and fan are off
+    bedMachine.start(STATE_OFF);
+
+    //from here on frames go out on the display's own thread, everything
+    //else on the bus is set up by now
+    display.beginAsync();
+
+    //and the outlets are switched from theirs, a slow one can't stall the loop
+    outlets.begin();
 
 }
 
 
 void loop() {
+    unsigned int idle;
 
-    programLogic();
+    scheduler.run();
+    timers.run();
+
+    if (profileLoop) {profiler.loopDone();}
+
+    //nothing is due until the next task or timer, give the time back till then
+    idle = scheduler.nextDue();
+    if (timers.nextDeadline() < idle) {idle = timers.nextDeadline();}
+    if (idle > 0) {delay(idle);}
 
  }
 
 void programLogic()
 {
-    
-    //There are multiple states the application can be in
-    // 0 - off
-    // 1 - setup mode
-    // 2 - waiting to cool
-    // 3 - cooling
-    // 4 - waiting to heat
-    // 5 - heating
+    //joystick first, then what the temperature and motion sensor say,
+    //states that don't care about an event have no transition for it
+    bedMachine.dispatch(joystickEvent());
+    bedMachine.dispatch(temperatureEvent());
+    bedMachine.update();
+}
 
-    //read the temperature
-    currentTemp = (bme.readTemperature ()*9/5)+32.0; // deg F
+int joystickEvent()
+{
+    int buttonEvent;
 
-    //this is for debugging only
-    if (debugButton.isClicked()==true)
+    //the joystick samples itself on a timer, each push is one gesture
+    switch (joystick.nextGesture())
     {
-        //Serial.printf("Start %i, Temp %0.1f%cF\n\n",0,currentTemp,248);
-        Serial.printf("Application %i, SetupState %i \n",applicationState,setupState);
-        Serial.printf("Forcecool %i, forceheat %i motion %i\n",forceCool,forceHeat,motionDetected);
-        Serial.printf("Currenttemp %f, cooltemp %f heatingtemp %f\n",currentTemp,coolingTemp,heatingTemp);
-        Serial.printf("\n");
+        case JOY_UP:    return EVT_UP;
+        case JOY_DOWN:  return EVT_DOWN;
+        case JOY_LEFT:  return EVT_LEFT;
+        case JOY_RIGHT: return EVT_RIGHT;
     }
 
-    //determine what state you should be in
-    prevApplicationState = applicationState;
-    if (forceCool==true)
-    {
-        forceHeat=false;
-        applicationState=3;
-        setupState=0;
-    }
-    if (forceHeat==true)
+    //the button queues its own events, only a press does anything
+    while ((buttonEvent = joyButton.nextEvent()) != BUTTON_NONE)
     {
-        forceCool = false;
-        applicationState = 5;
-        setupState=0;
-    }
-
-    //when you're in running mode
-    if(forceCool==false && forceHeat==false && applicationState>1)
-    {  
-        //go throught the temperature and motion settings
-        if(currentTemp>=coolingTemp)
-        {   
-            if (motionDetected==true)
-            {
-                applicationState=3;
-            }
-            else
-            {
-                applicationState=2;
-            }
-        }
-        
-        //if the temperature goes below the heating temp, turn on 
-        if(currentTemp<heatingTemp)
-        {
-            if (motionDetected==true)
-            {
-                applicationState=5;
-            }
-            else
-            {
-                applicationState=4;
-            }
-        }
+        if (buttonEvent==BUTTON_PRESS) {return EVT_BUTTON;}
     }
+    return EVT_NONE;
+}
 
+int temperatureEvent()
+{
+    ControlInput input;
+    ControlDecision decision;
+    int state = bedMachine.state();
 
-    //only update the display if something changes
-    if(applicationState!=prevApplicationState){showDisplay=true;}
-
-
-    switch (applicationState)
+    //only the running states follow the thermostat, the rest start it over
+    if (state!=STATE_WAIT_COOL && state!=STATE_COOLING && state!=STATE_WAIT_HEAT && state!=STATE_HEATING)
     {
-    case 0: 
-        //this is off
-
-        //turn off the neopixels
-        setPixelDisplay(0);
-
-        //turn off the display
-        if(showDisplay)
-        {
-            display.clearDisplay();
-            display.display();
-            showDisplay=false;
+        thermostat->reset(millis());
+        return EVT_NONE;
+    }
+    //nothing to go on until the first sample is in
+    if (sampler.written()==0) {return EVT_NONE;}
+
+    input.temp = currentTemp;
+    input.heatingTemp = heatingTemp;
+    input.coolingTemp = coolingTemp;
+    input.occupied = motionDetected;
+    input.now = millis();
+    decision = thermostat->decide(input);
+
+    if (decision.run==ACTION_COOL) {return EVT_HOT_MOTION;}
+    if (decision.run==ACTION_HEAT) {return EVT_COLD_MOTION;}
+    if (decision.demand==ACTION_COOL) {return EVT_HOT_IDLE;}
+    if (decision.demand==ACTION_HEAT) {return EVT_COLD_IDLE;}
+    return EVT_COMFORT;
+}
 
-            //turn off the heater
-            wemoWrite(wemoHeat,LOW);
+void drawTitle(const char *title, int textSize)
+{
+    display.setTextColor(WHITE);
+    display.setTextSize(textSize);
+    display.setCursor(20,0);
+    display.print(title);
+}
 
-            //turn off the fan
-            wemoWrite(wemoCool,LOW);
+void drawSetpointScreen(const char *title)
+{
+    display.drawBitmap(0, 9,graphic_updown,16,46, 1);
+    drawTitle(title,1);
+}
 
-        }
-          
-        //if user clicks on button, start  running process
-        if (joyButton.isPressed()==true)
-        {
-            Serial.print("Push joystick button");
-            applicationState=1;
-            showDisplay=true;
-        }
+void drawScreen(int screen)
+{
+    //only what never changes, the buffer is already clear
+    switch (screen)
+    {
+        case SCREEN_ONOFF:
+            display.drawBitmap(20, 0,graphic_onoff, 80,68, 1);
+            break;
+        case SCREEN_SET_COOL:
+            drawSetpointScreen("Set cooling temp");
+            break;
+        case SCREEN_SET_HEAT:
+            drawSetpointScreen("Set heating temp");
+            break;
+        case SCREEN_MANUAL:
+            display.drawBitmap(9, 5,graphic_hotcold,110,51, 1);
+            break;
+        case SCREEN_WAIT_COOL:
+            drawTitle("Waiting to cool",1);
+            break;
+        case SCREEN_WAIT_HEAT:
+            drawTitle("Wating to heat",1);
+            break;
+        case SCREEN_COOLING:
+            drawTitle("Cooling",2);
+            break;
+        case SCREEN_HEATING:
+            drawTitle("Heating",2);
+            break;
+    }
+}
 
-        //set these back to default off
-        forceHeat = false;
-        forceCool = false;
-        break;
-    
-    case 1:  
-        //setup mode
+void showSetpoint(int screen, int32_t setpoint)
+{
+    screens.show(screen);
+
+    //the setpoint goes on top of the cached screen
+    display.setTextColor(WHITE);
+    display.setTextSize(2);
+    display.setCursor(60,25);
+    display.printf("%li",(long)(setpoint/100));
+    updateDisplay();
+}
 
-        setPixelDisplay(1);
-        newVer = analogRead(joyVert);
-        newHor = analogRead(joyHorz);
-        switch (setupState)
-        {
-        case 0: //on off screen
-            
-            if(showDisplay)
-            {
-                display.clearDisplay();
-                display.drawBitmap(20, 0,graphic_onoff, 80,68, 1);
-                display.display();
-                showDisplay=false;
-
-                //turn off the heater
-                wemoWrite(wemoHeat,LOW);
-
-                //turn off the fan
-                wemoWrite(wemoCool,LOW);
-
-            }
-
-            //DOWN set the application state back to off
-            if(newVer>3500){setVertDown=true;}
-            if(newVer<3500 && setVertDown==true)
-            {
-                applicationState = 0;
-                setVertDown = false;
-                showDisplay=true;
-            }
-
-            //UP turn it on
-            if(newVer<1500){setVertUp=true;}
-            if(newVer>1500 && setVertUp==true)
-            {
-                applicationState = 2;
-                setHorRight = false;setHorLeft= false;setVertDown=false;setVertUp=false;
-                showDisplay=true;
-            }
-
-
-            //RIGHT, go to the cooling teperature screen
-            if(newHor>3500){setHorRight=true;}
-            if(newHor<3500 && setHorRight==true)
-            {
-                setHorRight = false;setHorLeft= false;setVertDown=false;setVertUp=false;
-                setupState = 1;
-                showDisplay=true;
-            }
-            
-            //set these back to default off
-            forceHeat = false;
-            forceCool = false;
+void enterOff()
+{
+    //turn off the display
+    display.clearDisplay();
+    updateDisplay();
 
-            break;
+    //turn off the heater
+    outletWrite(wemoHeat,LOW);
 
-        case 1:
-            //set cooling termperature
-
-            //up down arrow
-            if (showDisplay)
-            {
-                display.clearDisplay();
-                display.drawBitmap(0, 9,graphic_updown,16,46, 1);
-                display.setTextColor(WHITE);
-                display.setTextSize(1);
-                display.setCursor(20,0);
-                display.printf("Set cooling temp");
-
-                display.setTextSize(2);
-                display.setCursor(60,25);
-                display.printf("%.0f",coolingTemp);
-                display.display();
-                showDisplay=false;
-            }
-            
-            //RIGHT, go to the heating teperature screen
-            if(newHor>3500){setHorRight=true;}
-            if(newHor<3500 && setHorRight==true)
-            {
-                setHorRight = false;setHorLeft= false;setVertDown=false;setVertUp=false;
-                setupState = 2;
-                showDisplay=true;
-            }
-
-            //LEFT, go to on off screen
-            if(newHor<1000){setHorLeft=true;}
-            if(newHor>1000 && setHorLeft==true)
-            {
-                setHorRight = false;setHorLeft= false;setVertDown=false;setVertUp=false;
-                setupState = 0;
-                showDisplay=true;
-            }
-
-            //UP, increase the cooling termperature
-            if(newVer>3000){setVertUp=true;}
-            if(newVer<3000 && setVertUp==true)
-            {
-                setHorRight = false;setHorLeft= false;setVertDown=false;setVertUp=false;
-                coolingTemp--;
-
-                //keep the temps from overlapping
-                if(heatingTemp>=coolingTemp){heatingTemp=coolingTemp-1.0;}
-
-                showDisplay=true;
-            }
-
-            //DOWN, decrease the cooling termperature
-            if(newVer<1000){setVertDown=true;}
-            if(newVer>1000 && setVertDown==true)
-            {
-                setHorRight = false;setHorLeft= false;setVertDown=false;setVertUp=false;
-                coolingTemp++;
-
-                //keep the temps from overlapping
-                if(heatingTemp>=coolingTemp){heatingTemp=coolingTemp-1.0;}
-
-                showDisplay=true;
-            }
+    //turn off the fan
+    outletWrite(wemoCool,LOW);
+}
 
-            break;
-        
-        case 2:
-            //set heting termperature
-            if(showDisplay)
-            {
-                display.clearDisplay();
-                display.drawBitmap(0, 9,graphic_updown,16,46, 1);
-                display.setTextColor(WHITE);
-                display.setTextSize(1);
-                display.setCursor(20,0);
-                display.printf("Set heating temp");
-
-                display.setTextSize(2);
-                display.setCursor(60,25);
-                display.printf("%.0f",heatingTemp);
-                display.display();
-                showDisplay=false;
-            }
-
-            //LEFT, go to on off screen
-            if(newHor<1000){setHorLeft=true;}
-            if(newHor>1000 && setHorLeft==true)
-            {
-                setHorRight = false;setHorLeft= false;setVertDown=false;setVertUp=false;
-                setupState = 1;
-                showDisplay=true;
-            }
-
-            //UP, increase the heating termperature
-            if(newVer>3000){setVertUp=true;}
-            if(newVer<3000 && setVertUp==true)
-            {
-                setHorRight = false;setHorLeft= false;setVertDown=false;setVertUp=false;
-                heatingTemp--;
-
-                //keep the temps from overlapping
-                if(heatingTemp>=coolingTemp){coolingTemp=heatingTemp+1.0;}
-
-                showDisplay=true;
-            }
-
-            //DOWN, increase the heating termperature
-            if(newVer<1000){setVertDown=true;}
-            if(newVer>1000 && setVertDown==true)
-            {
-                setHorRight = false;setHorLeft= false;setVertDown=false;setVertUp=false;
-                heatingTemp++;
-
-                //keep the temps from overlapping
-                if(heatingTemp>=coolingTemp){coolingTemp=heatingTemp+1.0;}
-
-                showDisplay=true;
-            }
-
-            //Right, go to manual screen
-            if(newHor>3000){setHorRight=true;}
-            if(newHor<3000 && setHorRight==true)
-            {
-                setHorRight = false;setHorLeft= false;setVertDown=false;setVertUp=false;
-                setupState = 3;
-                showDisplay=true;
-            }
+void enterSetupOnOff()
+{
+    screens.show(SCREEN_ONOFF);
+    updateDisplay();
+}
 
-            break;
-        
-        case 3:
-            //manual heat or cool
-            if(showDisplay)
-            {
-                display.clearDisplay();
-                display.drawBitmap(9, 5,graphic_hotcold,110,51, 1);
-                display.setTextColor(WHITE);
-                display.display();
-                showDisplay=false;
-            }
-
-            //UP, start heat
-            if(newVer<1000){setVertDown=true;}
-            if(newVer>1000 && setVertDown==true)
-            {
-                setHorRight = false;setHorLeft= false;setVertDown=false;setVertUp=false;
-                forceHeat = true;
-                showDisplay=true;
-            }
-
-            //DOWN, start cooling
-            if(newVer>3000){setVertUp=true;}
-            if(newVer<3000 && setVertUp==true)
-            {
-                setHorRight = false;setHorLeft= false;setVertDown=false;setVertUp=false;
-                forceCool = true;
-                showDisplay=true;
-            }
-
-            //LEFT, to the heat temp screen
-            if(newHor<1000){setHorLeft=true;}
-            if(newHor>1000 && setHorLeft==true)
-            {
-                setHorRight = false;setHorLeft= false;setVertDown=false;setVertUp=false;
-                setupState = 2;
-                showDisplay=true;
-            }
-            break;
-        }
-        break;
-    
-    case 2:  //wating to cool
-        setPixelDisplay(2);
-        
-        //tell the user, it's waiting to cool
-        if(showDisplay)
-        {
-            waitedTime = 0;
-            waitTimer.startTimer(1000);   
-            motionDetected=0;
+void enterSetupCool()
+{
+    showSetpoint(SCREEN_SET_COOL,coolingTemp);
+}
 
-            display.clearDisplay();
-            display.setTextColor(WHITE);
-            display.setTextSize(1);
-            display.setCursor(20,0);
-            display.printf("Waiting to cool");
-            display.display();
-            showDisplay=false;
-        }
+void enterSetupHeat()
+{
+    showSetpoint(SCREEN_SET_HEAT,heatingTemp);
+}
 
-        //do a countdown, so the motion sensor doesn't start reading
-        //for 10 seconds
-        if (waitedTime < sensorWaitTime)
-        {
-            if (waitTimer.isTimerReady()==true)
-            {
-                display.fillRect(50,20, 70,30,BLACK);
-                display.setTextColor(WHITE);
-                display.setTextSize(2);
-                display.setCursor(50,20);
-                display.printf("%i",sensorWaitTime-waitedTime);
-                display.display();
-                waitedTime++;
-                waitTimer.startTimer(1000); 
-                forceCool=false;forceHeat=false;
-            }
-        }
-        else
-        {
-            //read the motion sensor
-            display.fillRect(50,20, 70,30,BLACK);
-            display.display();
-            motionDetected = digitalRead(DETECTPIN);
-        }
+void enterSetupManual()
+{
+    screens.show(SCREEN_MANUAL);
+    updateDisplay();
+}
 
-        //LEFT, go back to setup screen
-        if(newHor<1000){setHorLeft=true;}
-        if(newHor>1000 && setHorLeft==true)
-        {
-            //Serial.print("Cooling left button");
-            setHorRight = false;setHorLeft= false;setVertDown=false;setVertUp=false;
-            applicationState = 1;
-            setupState=0;
-            waitedTime = 0;
-            motionDetected=false;
-            showDisplay=true;
-            forceCool=false;forceHeat=false;
-        }
+void startCountdown()
+{
+    //the motion sensor doesn't start reading for 10 seconds,
+    //the first step shows the 10 as soon as the screen is drawn
+    timers.cancel(countdownTimer);
+    waitedTime = 0;
+    countdownTimer = timers.add(countdownStep,0);
+    motionDetected=false;
+}
 
+void enterWaitCool()
+{
+    startCountdown();
 
-        break;
+    //tell the user, it's waiting to cool
+    screens.show(SCREEN_WAIT_COOL);
+    updateDisplay();
+}
 
+void enterWaitHeat()
+{
+    startCountdown();
 
-    case 3:  //Cooling
-        setPixelDisplay(3);
-        newHor = analogRead(joyHorz);
+    //tell the user, it's waiting to heat
+    screens.show(SCREEN_WAIT_HEAT);
+    updateDisplay();
+}
 
-        //tell the user, it's cooling
-        if(showDisplay)
-        {
-            display.clearDisplay();
-            display.setTextColor(WHITE);
-            display.setTextSize(2);
-            display.setCursor(20,0);
-            display.printf("Cooling");
-            display.display();
-            showDisplay=false;
-
-            //turn on fan here
-            wemoWrite(wemoCool,HIGH);
-        }
+void stopCountdown()
+{
+    //leaving before the countdown finished, don't let it draw on the next screen
+    timers.cancel(countdownTimer);
+    countdownTimer = -1;
+}
 
-        //LEFT, go back to setup screen
-        if(newHor<1000){setHorLeft=true;}
-        if(newHor>1000 && setHorLeft==true)
-        {
-            setHorRight = false;setHorLeft= false;setVertDown=false;setVertUp=false;
-            applicationState = 1;
-            setupState=0;
-            waitedTime = 0;
-            motionDetected=false;
-            showDisplay=true;
-            forceCool=false;forceHeat=false;
-        }
+void countdownStep()
+{
+    //show the seconds left, then clear it once the wait is over
+    display.fillRect(50,20, 70,30,BLACK);
+    if (waitedTime < sensorWaitTime)
+    {
+        display.setTextColor(WHITE);
+        display.setTextSize(2);
+        display.setCursor(50,20);
+        display.printf("%i",sensorWaitTime-waitedTime);
+        waitedTime++;
+        countdownTimer = timers.add(countdownStep,1000);
+    }
+    else
+    {
+        countdownTimer = -1;
+    }
+    updateDisplay();
+}
 
-        break;
+void waitCountdown()
+{
+    //the motion sensor is only read once the countdown is done
+    if (countdownTimer >= 0)
+    {
+        return;
+    }
+    motionDetected = motion.within(MOTION_HOLD);
+}
 
-    case 4:  //Wating to heat
-        setPixelDisplay(4);
+void enterCooling()
+{
+    //tell the user, it's cooling
+    screens.show(SCREEN_COOLING);
+    updateDisplay();
 
-        //tell the user, it's cooling
-        if(showDisplay)
-        {   waitedTime = 0;
-            waitTimer.startTimer(1000); 
-            motionDetected=0;
+    //turn on fan here
+    outletWrite(wemoCool,HIGH);
+}
 
-            display.clearDisplay();
-            display.setTextColor(WHITE);
-            display.setTextSize(1);
-            display.setCursor(20,0);
-            display.printf("Wating to heat");
-            display.display();
-            showDisplay=false;
-        }
+void exitCooling()
+{
+    outletWrite(wemoCool,LOW);
+}
 
-        //do a countdown, so the motion sensor doesn't 
-        //start reading for 10 seconds
-        if (waitedTime < sensorWaitTime)
-        {
-            if (waitTimer.isTimerReady()==true)
-            {
-                display.fillRect(50,20, 70,30,BLACK);
-                display.setTextColor(WHITE);
-                display.setTextSize(2);
-                display.setCursor(50,20);
-                display.printf("%i",sensorWaitTime-waitedTime);
-                display.display();
-                waitedTime++;
-                waitTimer.startTimer(1000); 
-            }
-        }
-        else
-        {
-            //read the motion sensor
-            display.fillRect(50,20, 70,30,BLACK);
-            display.display();
-            motionDetected = digitalRead(DETECTPIN);
-        }
+void enterHeating()
+{
+    //tell the user, it's heating
+    screens.show(SCREEN_HEATING);
+    updateDisplay();
 
-        //LEFT, go back to setup screen
-        if(newHor<1000){setHorLeft=true;}
-        if(newHor>1000 && setHorLeft==true)
-        {
-            setHorRight = false;setHorLeft= false;setVertDown=false;setVertUp=false;
-            applicationState = 1;
-            setupState=0;
-            waitedTime = 0;
-            motionDetected=false;
-            showDisplay=true;
-            forceCool=false;forceHeat=false;
-        }
+    //turn on heater here
+    outletWrite(wemoHeat,HIGH);
+}
 
-        break;
+void exitHeating()
+{
+    outletWrite(wemoHeat,LOW);
+}
 
-    case 5:  //heating
-        setPixelDisplay(5);
-        newHor = analogRead(joyHorz);
-        
-        //tell the user, it's cooling
-        if(showDisplay)
-        {
-            display.clearDisplay();
-            display.setTextColor(WHITE);
-            display.setTextSize(2);
-            display.setCursor(20,0);
-            display.printf("Heating");
-            display.display();
-            showDisplay=false;
-
-            //turn on heater here
-            wemoWrite(wemoHeat,HIGH);
-        }
+void raiseCoolingTemp()
+{
+    coolingTemp += TEMP_STEP;
+}
 
-        //LEFT, go back to setup screen
-        if(newHor<1000){setHorLeft=true;}
-        if(newHor>1000 && setHorLeft==true)
-        {
-            Serial.print("Heating left button");
-            setHorRight = false;setHorLeft= false;setVertDown=false;setVertUp=false;
-            applicationState = 1;
-            setupState=0;
-            waitedTime = 0;
-            motionDetected=false;
-            forceHeat=false;
-            showDisplay=true;
-        }
+void lowerCoolingTemp()
+{
+    coolingTemp -= TEMP_STEP;
 
-        break;
+    //keep the temps from overlapping
+    if(heatingTemp>=coolingTemp){heatingTemp=coolingTemp-TEMP_STEP;}
+}
 
-    default:
-        break;
-    }
+void raiseHeatingTemp()
+{
+    heatingTemp += TEMP_STEP;
 
+    //keep the temps from overlapping
+    if(heatingTemp>=coolingTemp){coolingTemp=heatingTemp+TEMP_STEP;}
+}
 
+void lowerHeatingTemp()
+{
+    heatingTemp -= TEMP_STEP;
 }
 
 
 void setPixelDisplay(int theState)
 {
-    static int lastSwitch;
-    static bool onOff;
-    int brightNess;
-    bool useHue = false;
+    static int filledColor = -1;
 
+    //picking the same pattern again keeps it going where it was
     switch (theState)
     {
-        case 0:
-            //bed is off
-            pixel.clear();
-            pixel.show();
-            if (useHue) {(BULB,false,0,0,0);}
-            break;
-
-        case 1:  
+        case 1:
             //setup mode  (blinking white every second)
-            if(millis()-lastSwitch>500)
-            {
-                pixel.setBrightness(10);
-                onOff = !onOff;
-                if (onOff==true)
-                {
-                    PixelFill(0,PIXELCOUNT-1,white);
-                    if (useHue) {setHue(BULB,true,HueOrange,75,10);}
-                }
-                else
-                {
-                    pixel.clear();
-                    if (useHue) {setHue(BULB,false,0,0,0);}
-                }
-                pixel.show();
-                lastSwitch = millis();
-            }
+            ring.blink(white,10,1000);
             break;
 
-        case 2: 
+        case 2:
             // bed is ready to be cold (breath blue)
-            PixelFill(0,PIXELCOUNT-1,blue);
-            brightNess = 7 * sin(2.0*M_PI*(2.0/5.0)*millis()/1000.0)+ 10;
-            pixel.setBrightness(brightNess);
-            pixel.show();
-            if (useHue) {setHue(BULB,true,HueBlue,brightNess,255);}
+            ring.breathe(blue,BREATHE_LOW,BREATHE_HIGH,BREATHE_PERIOD);
             break;
 
         case 3:
             //bed is in cold mode (steady blue)
-            PixelFill(0,PIXELCOUNT-1,blue);
-            pixel.setBrightness(40);
-            pixel.show();
-            if (useHue) {setHue(BULB,true,HueBlue,100,255);}
+            ring.steady(blue,40);
             break;
 
         case 4:
             // bed is ready to be hot (breathing yellow)
-            PixelFill(0,PIXELCOUNT-1,yellow);
-            brightNess = 7 * sin(2.0*M_PI*(2.0/5.0)*millis()/1000.0)+ 10;
-            pixel.setBrightness(brightNess);
-            pixel.show();
-            if (useHue) {setHue(BULB,true,HueYellow,brightNess,255);}
+            ring.breathe(yellow,BREATHE_LOW,BREATHE_HIGH,BREATHE_PERIOD);
             break;
 
         case 5:
             //bed is in heat mode (steady yellow)
-            PixelFill(0,PIXELCOUNT-1,yellow);
-            pixel.setBrightness(40);
-            pixel.show();
-            if (useHue) {setHue(BULB,true,HueYellow,100,255);}
+            ring.steady(yellow,40);
             break;
 
         default:
             //bed is off
-            pixel.clear();
-            pixel.show();
-            if (useHue) {setHue(BULB,false,0,0,0);}
+            ring.off();
             break;
     }
 
+    //the strip is only filled and sent when the frame is different from the last one
+    if (!ring.update(millis())) {return;}
+
+    //brightness is applied as the strip is sent, so the pixels only
+    //have to be filled again when the color itself changes
+    profiler.begin(PROFILE_PIXELS);
+    pixel.setBrightness(ring.brightness());
+    if (ring.color()!=filledColor)
+    {
+        PixelFill(0,PIXELCOUNT-1,ring.color());
+        filledColor = ring.color();
+    }
+    pixelShow();
+    profiler.end(PROFILE_PIXELS);
+
+    if (useHue) {setHueDisplay(theState);}
+}
+
+void setHueDisplay(int theState)
+{
+    static int lastState = -1;
+    static int lastColor = -1;
+    static unsigned int lastSent = 0;
+
+    //a new pattern or a blink goes out right away, a breath only once every HUE_PERIOD
+    if (theState==lastState && ring.color()==lastColor && millis()-lastSent<HUE_PERIOD) {return;}
+    lastState = theState;
+    lastColor = ring.color();
+    lastSent = millis();
+
+    //the hue bulb follows the ring, only called when the ring changed
+    switch (theState)
+    {
+        case 1:
+            if (ring.color()!=0) {setHue(BULB,true,HueOrange,75,10);}
+            else {setHue(BULB,false,0,0,0);}
+            break;
+
+        case 2:
+            setHue(BULB,true,HueBlue,ring.brightness(),255);
+            break;
+
+        case 3:
+            setHue(BULB,true,HueBlue,100,255);
+            break;
+
+        case 4:
+            setHue(BULB,true,HueYellow,ring.brightness(),255);
+            break;
+
+        case 5:
+            setHue(BULB,true,HueYellow,100,255);
+            break;
+
+        default:
+            setHue(BULB,false,0,0,0);
+            break;
+    }
 }
 
 void PixelFill(int startPixel, int endPixel, int theColor)
@@ -776,4 +652,214 @@ void SetHueOnce(int LightNum,bool HueON,int HueColor,int HueBright, int HueSat)
         oldHueBright = HueBright;
         oldHueSat = HueSat;
     }
-}
\ No newline at end of file
+}
+
+void readSensors()
+{
+    static unsigned int tempCursor;
+    BME280Sampler::Sample sample;
+
+    //the bus is only used when the sensor has a new sample
+    profiler.begin(PROFILE_SENSOR);
+    if (sampler.poll()) {profiler.addBusBytes(BUS_I2C,BME_READ_BYTES);}
+    profiler.end(PROFILE_SENSOR);
+
+    //the thermostat takes each new sample from the buffer
+    while (sampler.next(tempCursor,sample))
+    {
+        if (sample.value.temperatureCenti!=Adafruit_BME280::TEMPERATURE_INVALID)
+        {
+            currentTemp = Adafruit_BME280::centiCelsiusToFahrenheit(sample.value.temperatureCenti);
+        }
+    }
+}
+
+void readInputs()
+{
+    bool debugClicked;
+    int buttonEvent;
+    MotionSensor::Edge edge;
+
+    profiler.begin(PROFILE_INPUT);
+    debugClicked = false;
+    while ((buttonEvent = debugButton.nextEvent()) != BUTTON_NONE)
+    {
+        if (buttonEvent==BUTTON_CLICK) {debugClicked = true;}
+    }
+
+    //count every time the dog moved, even ones between loop passes
+    while (motion.next(edge))
+    {
+        if (edge.rising) {motionCount++;}
+    }
+    profiler.end(PROFILE_INPUT);
+
+    //this is for debugging only
+    if (debugClicked==true)
+    {
+        //Serial.printf("Start %i, Temp %0.1f%cF\n\n",0,currentTemp,248);
+        Serial.printf("State %i, motion %i, %u motions (%u lost)\n",bedMachine.state(),motionDetected,motionCount,motion.dropped());
+        Serial.printf("Currenttemp %li, cooltemp %li heatingtemp %li (1/100 F)\n",(long)currentTemp,(long)coolingTemp,(long)heatingTemp);
+        httpPool.printStats();
+        outlets.printStats();
+        Serial.printf("Sensor samples %u\n",sampler.written());
+        Serial.printf("Thermostat outlet switches %u\n",thermostat->commands());
+        Serial.printf("Display bytes saved %lu, frames held %lu, bus transactions %lu\n",(unsigned long)display.bytesSaved(),
+            (unsigned long)display.coalescedFrames(),(unsigned long)display.busTransactions());
+        Serial.printf("\n");
+    }
+
+    //the state logic works off the inputs, so it runs right after them
+    programLogic();
+}
+
+void updatePixels()
+{
+    setPixelDisplay(statePixels[bedMachine.state()]);
+}
+
+void updateDisplay()
+{
+    //the frame buffer goes out on the next display tick
+    displayDirty = true;
+}
+
+void refreshDisplay()
+{
+    static unsigned long lastBusBytes = 0;
+    unsigned long busBytes;
+
+    //the flush thread counts bytes as it sends them, add what went out since last time
+    busBytes = display.busBytes();
+    profiler.addBusBytes(BUS_I2C,busBytes-lastBusBytes);
+    lastBusBytes = busBytes;
+
+    if (!displayDirty) {return;}
+
+    //the display only sends the part that was drawn on, and only
+    //copies it here, the sending is done on the display's thread
+    profiler.begin(PROFILE_DISPLAY);
+    display.display();
+    profiler.end(PROFILE_DISPLAY);
+
+    //if the last frame was still going out this one waits for the next tick
+    displayDirty = display.pending();
+}
+
+void pixelShow()
+{
+    //already inside the pixels section of setPixelDisplay()
+    pixel.show();
+    profiler.addBusBytes(BUS_SPI,PIXEL_SHOW_BYTES);
+}
+
+void outletWrite(int outlet, bool outletState)
+{
+    //returns right away, updateOutlets() sends it
+    outlets.write(outlet,outletState);
+}
+
+void updateOutlets()
+{
+    unsigned int sent = outlets.sentCount();
+
+    profiler.begin(PROFILE_NETWORK);
+    outlets.pump();
+    profiler.end(PROFILE_NETWORK);
+    if (outlets.sentCount()!=sent) {profiler.addBusBytes(BUS_TCP,WEMO_REQUEST_BYTES);}
+}
+
+void runDisplayBenchmark()
+{
+    struct BitmapAsset {
+        const char *name;
+        const unsigned char *bitmap;
+        int x, y, w, h;
+    };
+    const BitmapAsset assets[] = {
+        {"updown",  graphic_updown,  0,  9, 16, 46},
+        {"onoff",   graphic_onoff,   20, 0, 80, 68},
+        {"hotcold", graphic_hotcold, 9,  5, 110,51}
+    };
+    unsigned long start, pixelTime, blitTime;
+
+    //the same bitmaps the screens draw, pixel by pixel and then with the blitter
+    Serial.printf("Bitmap draw, us per draw over %i draws\n",BENCHMARK_RUNS);
+    for (const BitmapAsset &asset : assets)
+    {
+        start = micros();
+        for (int i=0; i<BENCHMARK_RUNS; i++) {
+            display.Adafruit_GFX::drawBitmap(asset.x,asset.y,asset.bitmap,asset.w,asset.h,WHITE);}
+        pixelTime = micros()-start;
+
+        start = micros();
+        for (int i=0; i<BENCHMARK_RUNS; i++) {
+            display.drawBitmap(asset.x,asset.y,asset.bitmap,asset.w,asset.h,WHITE);}
+        blitTime = micros()-start;
+
+        Serial.printf("  %-8s pixel %5lu  blit %5lu  %lux faster\n",asset.name,
+            pixelTime/BENCHMARK_RUNS,blitTime/BENCHMARK_RUNS,pixelTime/(blitTime>0 ? blitTime : 1));
+    }
+
+    //characters on and off a page boundary, at the sizes the screens use
+    const int textSizes[] = {1,1,2,3};
+    const int textRows[] = {8,11,16,20};
+    const int BENCHMARK_CHARS = 16*BENCHMARK_RUNS;
+    Serial.printf("Text draw, chars per ms over %i chars\n",BENCHMARK_CHARS);
+    for (int t=0; t<4; t++)
+    {
+        start = micros();
+        for (int i=0; i<BENCHMARK_CHARS; i++) {
+            display.Adafruit_GFX::drawChar((i%16)*6,textRows[t],'0'+i%10,WHITE,BLACK,textSizes[t]);}
+        pixelTime = micros()-start;
+
+        start = micros();
+        for (int i=0; i<BENCHMARK_CHARS; i++) {
+            display.drawChar((i%16)*6,textRows[t],'0'+i%10,WHITE,BLACK,textSizes[t]);}
+        blitTime = micros()-start;
+
+        Serial.printf("  size %i at y %2i  pixel %5lu  page %5lu\n",textSizes[t],textRows[t],
+            (BENCHMARK_CHARS*1000UL)/(pixelTime>0 ? pixelTime : 1),(BENCHMARK_CHARS*1000UL)/(blitTime>0 ? blitTime : 1));
+    }
+
+    //every static screen, drawn from scratch and then copied from the cache
+    Serial.printf("Screen change, us per change\n");
+    for (int screen=0; screen<SCREEN_COUNT; screen++)
+    {
+        start = micros();
+        for (int i=0; i<BENCHMARK_RUNS; i++) {
+            display.clearDisplay();
+            drawScreen(screen);}
+        pixelTime = micros()-start;
+
+        screens.show(screen);
+        start = micros();
+        for (int i=0; i<BENCHMARK_RUNS; i++) {
+            screens.show(screen);}
+        blitTime = micros()-start;
+
+        Serial.printf("  screen %i  drawn %5lu  cached %5lu\n",screen,pixelTime/BENCHMARK_RUNS,blitTime/BENCHMARK_RUNS);
+    }
+
+    //a whole frame, byte by byte and then by DMA, DMA only happens on a
+    //hardware SPI display so on I2C both lines come out the same
+    unsigned long returned;
+    Serial.printf("Frame send, us for %i bytes\n",SSD1306_LCDWIDTH*SSD1306_LCDHEIGHT/8);
+    for (int dma=0; dma<2; dma++)
+    {
+        display.setDMA(dma==1);
+        display.invalidate();
+        start = micros();
+        display.display();
+        returned = micros()-start;
+        display.waitForFlush();
+        blitTime = micros()-start;
+
+        Serial.printf("  %-4s  display() %5lu  on screen %5lu  %lu bytes/ms\n",dma ? "dma" : "byte",returned,blitTime,
+            (SSD1306_LCDWIDTH*SSD1306_LCDHEIGHT/8*1000UL)/(blitTime>0 ? blitTime : 1));
+    }
+    display.setDMA(false);
+
+    //leave the screen how it was
+    display.clearDisplay();
+}
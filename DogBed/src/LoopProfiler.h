@@ -0,0 +1,112 @@
+#ifndef _LOOPPROFILER_H_
+#define _LOOPPROFILER_H_
+
+/*
+ *  Project: DogBed
+ *  Description: Loop rate, per subsystem time and per bus byte counters
+ *               so performance changes can be measured on the bed itself
+ *  Author: David Barbour
+ */
+
+#include "Particle.h"
+
+// the parts of programLogic() that get timed
+enum ProfileSection {
+  PROFILE_SENSOR,
+  PROFILE_INPUT,
+  PROFILE_DISPLAY,
+  PROFILE_PIXELS,
+  PROFILE_NETWORK,
+  PROFILE_SECTIONS
+};
+
+// the buses bytes are counted on
+enum ProfileBus {
+  BUS_I2C,
+  BUS_SPI,
+  BUS_TCP,
+  PROFILE_BUSES
+};
+
+class LoopProfiler {
+
+  unsigned int _reportInterval;
+  unsigned int _windowStart;
+  unsigned int _loops;
+  unsigned long _sectionStart[PROFILE_SECTIONS];
+  unsigned long _sectionMicros[PROFILE_SECTIONS];
+  unsigned long _busBytes[PROFILE_BUSES];
+
+  public:
+    LoopProfiler(unsigned int reportInterval=10000) {
+      _reportInterval = reportInterval;
+      reset();
+    }
+
+    void reset() {
+      _windowStart = millis();
+      _loops = 0;
+      for (int i=0; i<PROFILE_SECTIONS; i++) {
+        _sectionStart[i] = 0;
+        _sectionMicros[i] = 0;
+      }
+      for (int i=0; i<PROFILE_BUSES; i++) {
+        _busBytes[i] = 0;
+      }
+    }
+
+    void begin(ProfileSection section) {
+      _sectionStart[section] = micros();
+    }
+
+    void end(ProfileSection section) {
+      _sectionMicros[section] += micros() - _sectionStart[section];
+    }
+
+    void addBusBytes(ProfileBus bus, unsigned int bytes) {
+      _busBytes[bus] += bytes;
+    }
+
+    // call once at the end of every loop, prints a report when the window is up
+    void loopDone() {
+      unsigned int elapsed;
+
+      _loops++;
+      elapsed = millis() - _windowStart;
+      if (elapsed >= _reportInterval) {
+        report(elapsed);
+        reset();
+      }
+    }
+
+    // the window so far, for a last report before the window is up
+    void report() {
+      unsigned int elapsed = millis() - _windowStart;
+
+      if (elapsed > 0) {
+        report(elapsed);
+      }
+    }
+
+    void report(unsigned int elapsed) {
+      static const char *sectionNames[PROFILE_SECTIONS] = {"sensor","input","display","pixels","network"};
+      static const char *busNames[PROFILE_BUSES] = {"i2c","spi","tcp"};
+
+      Serial.printf("Loops/sec %lu (%u loops in %u ms)\n",perSecond(_loops,elapsed),_loops,elapsed);
+      for (int i=0; i<PROFILE_SECTIONS; i++) {
+        // us spent per second of wall time, /10000 gives the percentage
+        unsigned long busy = perSecond(_sectionMicros[i],elapsed);
+        Serial.printf("  %-8s %8lu us/sec %3lu%%\n",sectionNames[i],busy,busy/10000);
+      }
+      for (int i=0; i<PROFILE_BUSES; i++) {
+        Serial.printf("  %-8s %8lu bytes/sec\n",busNames[i],perSecond(_busBytes[i],elapsed));
+      }
+    }
+
+  private:
+    static unsigned long perSecond(unsigned long count, unsigned int elapsed) {
+      return (unsigned long)((unsigned long long)count * 1000 / elapsed);
+    }
+};
+
+#endif // _LOOPPROFILER_H_
@@ -0,0 +1,122 @@
+#ifndef _MOTIONSENSOR_H_
+#define _MOTIONSENSOR_H_
+
+/*
+ *  Project: DogBed
+ *  Description: PIR motion sensor read by interrupt. Every edge is caught
+ *               and timestamped even when the loop is busy or idle, and
+ *               "was there motion lately" is answered without the pin
+ *  Author: David Barbour
+ */
+
+#include "Particle.h"
+
+/* Usage:
+ * MotionSensor motion(D9);
+ * motion.begin();                  // in setup()
+ * motion.within(3000);             // motion now or in the last 3 seconds
+ *
+ * MotionSensor::Edge edge;
+ * while (motion.next(edge)) {...}  // every edge since the last call, oldest first
+ */
+
+class MotionSensor {
+
+  static const unsigned int EDGES = 16;   // power of 2 so the counters can wrap
+
+  public:
+    struct Edge {
+      unsigned int time;    // millis() of the edge
+      bool rising;          // true when motion started, false when it stopped
+    };
+
+  private:
+    int _pin;
+
+    // single producer (the interrupt) single consumer (next()) ring,
+    // only the interrupt moves _head and only next() moves _tail
+    volatile Edge _edges[EDGES];
+    volatile unsigned int _head;
+    volatile unsigned int _tail;
+    volatile unsigned int _dropped;
+
+    volatile bool _level;           // the pin as of the last edge
+    volatile bool _stopped;         // motion has stopped at least once
+    volatile unsigned int _stopTime;  // millis() motion last stopped
+
+  public:
+    MotionSensor(int pin) {
+      _pin = pin;
+      _head = _tail = 0;
+      _dropped = 0;
+      _level = false;
+      _stopped = false;
+      _stopTime = 0;
+    }
+
+    void begin() {
+      pinMode(_pin,INPUT);
+      _level = pinReadFast(_pin);
+      attachInterrupt(_pin,&MotionSensor::onChange,this,CHANGE);
+    }
+
+    // true if there is motion now, or there was in the last ms milliseconds
+    bool within(unsigned int ms) {
+      bool level, stopped;
+      unsigned int stopTime;
+
+      ATOMIC_BLOCK() {
+        level = _level;
+        stopped = _stopped;
+        stopTime = _stopTime;
+      }
+      if (level) {
+        return true;
+      }
+      return stopped && millis() - stopTime < ms;
+    }
+
+    // take the oldest edge not seen yet, returns false if there are none
+    bool next(Edge &edge) {
+      unsigned int tail = _tail;
+
+      if (tail == _head) {
+        return false;
+      }
+      edge.time = _edges[tail % EDGES].time;
+      edge.rising = _edges[tail % EDGES].rising;
+      _tail = tail + 1;
+      return true;
+    }
+
+    // edges lost because the ring was full
+    unsigned int dropped() {
+      return _dropped;
+    }
+
+  private:
+    void onChange() {
+      unsigned int now = millis();
+      bool level = pinReadFast(_pin);
+      unsigned int head = _head;
+
+      if (level == _level) {
+        return;   // a glitch shorter than the interrupt latency
+      }
+      _level = level;
+      if (!level) {
+        _stopTime = now;
+        _stopped = true;
+      }
+
+      if (head - _tail >= EDGES) {
+        _dropped++;
+        return;
+      }
+      _edges[head % EDGES].time = now;
+      _edges[head % EDGES].rising = level;
+      _head = head + 1;
+    }
+};
+
+#endif // _MOTIONSENSOR_H_
@@ -0,0 +1,166 @@
+#ifndef _PIXELANIMATOR_H_
+#define _PIXELANIMATOR_H_
+
+/*
+ *  Project: DogBed
+ *  Description: Status ring animations (steady, blink, breathe) worked out
+ *               with a phase accumulator and lookup tables instead of sin(),
+ *               and only reported as changed when the frame really changes
+ *  Author: David Barbour
+ */
+
+#include "Particle.h"
+
+/* Usage:
+ * PixelAnimator ring;
+ * ring.breathe(blue,3,17,2500);   // pick the pattern, same pattern again keeps its phase
+ * if (ring.update(millis())) {    // at the frame rate
+ *   pixel.setBrightness(ring.brightness());
+ *   ... fill with ring.color() and show()
+ * }
+ */
+
+// one cycle of a raised sine, 0 at the start and end, 255 in the middle
+static const uint8_t animSine[256] = {
+    0,  0,  0,  0,  1,  1,  1,  2,  2,  3,  4,  5,  5,  6,  7,  9,
+   10, 11, 12, 14, 15, 17, 18, 20, 21, 23, 25, 27, 29, 31, 33, 35,
+   37, 40, 42, 44, 47, 49, 52, 54, 57, 59, 62, 65, 67, 70, 73, 76,
+   79, 82, 85, 88, 90, 93, 97,100,103,106,109,112,115,118,121,124,
+  127,131,134,137,140,143,146,149,152,155,158,162,165,167,170,173,
+  176,179,182,185,188,190,193,196,198,201,203,206,208,211,213,215,
+  218,220,222,224,226,228,230,232,234,235,237,238,240,241,243,244,
+  245,246,248,249,250,250,251,252,253,253,254,254,254,255,255,255,
+  255,255,255,255,254,254,254,253,253,252,251,250,250,249,248,246,
+  245,244,243,241,240,238,237,235,234,232,230,228,226,224,222,220,
+  218,215,213,211,208,206,203,201,198,196,193,190,188,185,182,179,
+  176,173,170,167,165,162,158,155,152,149,146,143,140,137,134,131,
+  128,124,121,118,115,112,109,106,103,100, 97, 93, 90, 88, 85, 82,
+   79, 76, 73, 70, 67, 65, 62, 59, 57, 54, 52, 49, 47, 44, 42, 40,
+   37, 35, 33, 31, 29, 27, 25, 23, 21, 20, 18, 17, 15, 14, 12, 11,
+   10,  9,  7,  6,  5,  5,  4,  3,  2,  2,  1,  1,  1,  0,  0,  0,
+};
+
+// brightness steps that look even to the eye, gamma 2.6
+static const uint8_t animGamma[256] = {
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  1,  1,  1,  1,  1,  1,  1,  1,
+    1,  1,  1,  1,  2,  2,  2,  2,  2,  2,  2,  2,  3,  3,  3,  3,
+    3,  3,  4,  4,  4,  4,  5,  5,  5,  5,  5,  6,  6,  6,  6,  7,
+    7,  7,  8,  8,  8,  9,  9,  9, 10, 10, 10, 11, 11, 11, 12, 12,
+   13, 13, 13, 14, 14, 15, 15, 16, 16, 17, 17, 18, 18, 19, 19, 20,
+   20, 21, 21, 22, 22, 23, 24, 24, 25, 25, 26, 27, 27, 28, 29, 29,
+   30, 31, 31, 32, 33, 34, 34, 35, 36, 37, 38, 38, 39, 40, 41, 42,
+   42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57,
+   58, 59, 60, 61, 62, 63, 64, 65, 66, 68, 69, 70, 71, 72, 73, 75,
+   76, 77, 78, 80, 81, 82, 84, 85, 86, 88, 89, 90, 92, 93, 94, 96,
+   97, 99,100,102,103,105,106,108,109,111,112,114,115,117,119,120,
+  122,124,125,127,129,130,132,134,136,137,139,141,143,145,146,148,
+  150,152,154,156,158,160,162,164,166,168,170,172,174,176,178,180,
+  182,184,186,188,191,193,195,197,199,202,204,206,209,211,213,215,
+  218,220,223,225,227,230,232,235,237,240,242,245,247,250,252,255,
+};
+
+class PixelAnimator {
+
+  enum Pattern { ANIM_OFF, ANIM_STEADY, ANIM_BLINK, ANIM_BREATHE };
+
+  Pattern _pattern;
+  int _color;
+  uint8_t _low, _high;
+  unsigned int _period;
+  uint32_t _phase;          // top 8 bits index the tables, one full turn is a cycle
+  uint32_t _step;           // phase per ms
+  unsigned int _lastUpdate;
+  int _frameColor, _lastColor;
+  uint8_t _frameBrightness, _lastBrightness;
+  bool _shown;
+
+  public:
+    PixelAnimator() {
+      _pattern = ANIM_OFF;
+      _color = 0;
+      _low = _high = 0;
+      _period = 0;
+      _phase = 0;
+      _step = 0;
+      _lastUpdate = 0;
+      _frameColor = _lastColor = 0;
+      _frameBrightness = _lastBrightness = 0;
+      _shown = false;
+    }
+
+    void off() {
+      setPattern(ANIM_OFF,0,0,0,0);
+    }
+
+    void steady(int color, uint8_t brightness) {
+      setPattern(ANIM_STEADY,color,brightness,brightness,0);
+    }
+
+    // on for the first half of the period, off for the second
+    void blink(int color, uint8_t brightness, unsigned int period) {
+      setPattern(ANIM_BLINK,color,brightness,brightness,period);
+    }
+
+    // brightness goes low -> high -> low once every period
+    void breathe(int color, uint8_t low, uint8_t high, unsigned int period) {
+      setPattern(ANIM_BREATHE,color,low,high,period);
+    }
+
+    // move the animation on to now, returns true if the frame has to be shown
+    bool update(unsigned int now) {
+      _phase += (now - _lastUpdate) * _step;
+      _lastUpdate = now;
+
+      switch (_pattern) {
+        case ANIM_OFF:
+          _frameColor = 0;
+          _frameBrightness = 0;
+          break;
+
+        case ANIM_STEADY:
+          _frameColor = _color;
+          _frameBrightness = _high;
+          break;
+
+        case ANIM_BLINK:
+          _frameColor = (_phase < 0x80000000) ? _color : 0;
+          _frameBrightness = _high;
+          break;
+
+        case ANIM_BREATHE:
+          _frameColor = _color;
+          _frameBrightness = _low + (animGamma[animSine[_phase >> 24]] * (_high - _low) + 127) / 255;
+          break;
+      }
+
+      if (_shown && _frameColor == _lastColor && _frameBrightness == _lastBrightness) {
+        return false;
+      }
+      _lastColor = _frameColor;
+      _lastBrightness = _frameBrightness;
+      _shown = true;
+      return true;
+    }
+
+    int color() { return _frameColor; }
+    uint8_t brightness() { return _frameBrightness; }
+
+  private:
+    // a new pattern starts from the beginning of its cycle, the same one carries on
+    void setPattern(Pattern pattern, int color, uint8_t low, uint8_t high, unsigned int period) {
+      if (pattern == _pattern && color == _color && low == _low && high == _high && period == _period) {
+        return;
+      }
+      _pattern = pattern;
+      _color = color;
+      _low = low;
+      _high = high;
+      _period = period;
+      _phase = 0;
+      _step = period ? 0xFFFFFFFF / period : 0;
+      _lastUpdate = millis();
+    }
+};
+
+#endif // _PIXELANIMATOR_H_
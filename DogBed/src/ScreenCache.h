@@ -0,0 +1,142 @@
+#ifndef _SCREENCACHE_H_
+#define _SCREENCACHE_H_
+
+/*
+ *  Project: DogBed
+ *  Description: Keeps a copy of every screen that doesn't change, so going
+ *               back to one is a single copy into the display buffer
+ *               instead of clearing and drawing it all again. Only the pages
+ *               a screen draws on are kept, so a title bar costs one page
+ *  Author: David Barbour
+ */
+
+#include "Particle.h"
+#include "Adafruit_SSD1306.h"
+
+/* Usage:
+ * void drawScreen(int screen) {...}     // draws the fixed part of a screen on a cleared buffer
+ * ScreenCache<SCREEN_COUNT, 35> screens(display, drawScreen);   // room for 35 pages across all of them
+ *
+ * screens.show(SCREEN_COOLING);         // drawn the first time, copied every time after
+ * display.print(...);                   // anything that changes goes on top
+ *
+ * A screen that doesn't fit in what is left of the pages is drawn every time.
+ */
+
+template <int SCREENS, int PAGES = SCREENS * SSD1306_LCDHEIGHT / 8>
+class ScreenCache {
+
+  static const int PAGE = SSD1306_LCDWIDTH;             // bytes in a page
+  static const int DISPLAYPAGES = SSD1306_LCDHEIGHT / 8;
+
+  struct Snapshot {
+    bool cached;
+    int8_t page0, page1;    // pages it draws on, page0 > page1 when it draws nothing
+    int16_t start;          // first page of its copy in _pages, -1 if it has no room
+    int8_t room;            // pages it has there, kept when it is forgotten
+  };
+
+  Adafruit_SSD1306 &_display;
+  void (*_draw)(int screen);
+  uint8_t _pages[PAGES][PAGE];
+  int _pagesUsed;
+  Snapshot _screens[SCREENS];
+  unsigned int _hits;
+  unsigned int _misses;
+
+  public:
+    ScreenCache(Adafruit_SSD1306 &display, void (*draw)(int screen)) : _display(display) {
+      _draw = draw;
+      _hits = _misses = 0;
+      forgetAll();
+    }
+
+    // put the screen in the display buffer, it still needs a display() to be seen
+    void show(int screen) {
+      uint8_t *buffer = _display.getBuffer();
+      Snapshot *snapshot;
+
+      // not one of the screens it keeps, just draw it
+      if (screen < 0 || screen >= SCREENS) {
+        _display.clearDisplay();
+        _draw(screen);
+        return;
+      }
+
+      snapshot = &_screens[screen];
+      if (!snapshot->cached) {
+        _display.clearDisplay();
+        _draw(screen);
+        keep(*snapshot,buffer);
+        _misses++;
+        return;
+      }
+
+      _display.clearDisplay();
+      if (snapshot->page0 <= snapshot->page1) {
+        memcpy(buffer + snapshot->page0 * PAGE,_pages[snapshot->start],(snapshot->page1 - snapshot->page0 + 1) * PAGE);
+      }
+      _hits++;
+    }
+
+    // draw it again next time, for when what a screen looks like changes
+    void forget(int screen) {
+      if (screen >= 0 && screen < SCREENS) {
+        _screens[screen].cached = false;
+      }
+    }
+
+    void forgetAll() {
+      for (int i=0; i<SCREENS; i++) {
+        _screens[i].cached = false;
+        _screens[i].start = -1;
+        _screens[i].room = 0;
+      }
+      _pagesUsed = 0;
+    }
+
+    unsigned int hits() { return _hits; }
+    unsigned int misses() { return _misses; }
+    int pagesUsed() { return _pagesUsed; }
+
+  private:
+    // copy the pages the screen drew on, if there is room for them
+    void keep(Snapshot &snapshot, const uint8_t *buffer) {
+      int pages;
+
+      snapshot.page0 = DISPLAYPAGES;
+      snapshot.page1 = -1;
+      for (int page=0; page<DISPLAYPAGES; page++) {
+        if (!blank(buffer + page * PAGE)) {
+          if (page < snapshot.page0) {snapshot.page0 = page;}
+          snapshot.page1 = page;
+        }
+      }
+      pages = (snapshot.page0 <= snapshot.page1) ? snapshot.page1 - snapshot.page0 + 1 : 0;
+
+      // a forgotten screen reuses its old pages when it still fits in them
+      if (pages > snapshot.room) {
+        if (_pagesUsed + pages > PAGES) {
+          return;
+        }
+        snapshot.start = _pagesUsed;
+        snapshot.room = pages;
+        _pagesUsed += pages;
+      }
+      if (pages > 0) {
+        memcpy(_pages[snapshot.start],buffer + snapshot.page0 * PAGE,pages * PAGE);
+      }
+      snapshot.cached = true;
+    }
+
+    static bool blank(const uint8_t *page) {
+      for (int i=0; i<PAGE; i++) {
+        if (page[i]) {
+          return false;
+        }
+      }
+      return true;
+    }
+};
+
+#endif // _SCREENCACHE_H_
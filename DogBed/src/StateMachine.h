@@ -0,0 +1,116 @@
+#ifndef _STATEMACHINE_H_
+#define _STATEMACHINE_H_
+
+/*
+ *  Project: DogBed
+ *  Description: Table driven state machine. States and transitions are
+ *               constexpr tables, events are dispatched with one lookup
+ *  Author: David Barbour
+ */
+
+#include <stdint.h>
+
+const uint8_t NO_TRANSITION = 0xFF;
+
+// what happens while in a state, any of these can be NULL
+struct MachineState {
+  void (*entry)();    // runs once every time the state is entered
+  void (*exit)();     // runs once every time the state is left
+  void (*during)();   // runs on every update() while in the state
+};
+
+// one row per state/event pair that does something
+struct Transition {
+  uint8_t from;
+  uint8_t event;
+  uint8_t to;         // a transition back to the same state runs exit and entry again
+  void (*action)();   // runs between the exit and entry, can be NULL
+};
+
+// [state][event] -> row in the transition table, built at compile time
+template <int STATES, int EVENTS>
+struct DispatchIndex {
+  uint8_t row[STATES][EVENTS];
+};
+
+// not constexpr, so a table that reaches one of these can't be built at
+// compile time and the build stops at the bad row
+inline void duplicateTransition() {}
+inline void transitionOutOfRange() {}
+
+// build it constexpr, a bad table is only caught at compile time
+template <int STATES, int EVENTS, int ROWS>
+constexpr DispatchIndex<STATES,EVENTS> buildDispatchIndex(const Transition (&transitions)[ROWS]) {
+  DispatchIndex<STATES,EVENTS> index {};
+
+  static_assert(ROWS < NO_TRANSITION, "too many transitions for an 8 bit index");
+  for (int s=0; s<STATES; s++) {
+    for (int e=0; e<EVENTS; e++) {
+      index.row[s][e] = NO_TRANSITION;
+    }
+  }
+  for (int i=0; i<ROWS; i++) {
+    const Transition &t = transitions[i];
+    if (t.from >= STATES || t.event >= EVENTS || t.to >= STATES) {
+      transitionOutOfRange();
+      continue;     // built at run time, the row must not be used as an index
+    }
+    // a second row for the same state and event would quietly replace the first
+    if (index.row[t.from][t.event] != NO_TRANSITION) {
+      duplicateTransition();
+    }
+    index.row[t.from][t.event] = i;
+  }
+  return index;
+}
+
+template <int STATES, int EVENTS>
+class StateMachine {
+
+  const MachineState *_states;
+  const Transition *_transitions;
+  const DispatchIndex<STATES,EVENTS> &_index;
+  uint8_t _current;
+  bool _started;
+
+  public:
+    StateMachine(const MachineState *states, const Transition *transitions, const DispatchIndex<STATES,EVENTS> &index) :
+      _states(states), _transitions(transitions), _index(index), _current(0), _started(false) {}
+
+    // enter the first state, runs its entry action
+    void start(uint8_t initial) {
+      _current = initial;
+      _started = true;
+      if (_states[_current].entry) {_states[_current].entry();}
+    }
+
+    // returns true if the event caused a transition
+    bool dispatch(int event) {
+      uint8_t row;
+      const Transition *t;
+
+      if (!_started || event < 0 || event >= EVENTS) {
+        return false;
+      }
+      row = _index.row[_current][event];
+      if (row == NO_TRANSITION) {
+        return false;
+      }
+      t = &_transitions[row];
+      if (_states[_current].exit) {_states[_current].exit();}
+      if (t->action) {t->action();}
+      _current = t->to;
+      if (_states[_current].entry) {_states[_current].entry();}
+      return true;
+    }
+
+    void update() {
+      if (_started && _states[_current].during) {_states[_current].during();}
+    }
+
+    uint8_t state() const {
+      return _current;
+    }
+};
+
+#endif // _STATEMACHINE_H_
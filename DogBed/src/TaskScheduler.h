@@ -0,0 +1,93 @@
+#ifndef _TASKSCHEDULER_H_
+#define _TASKSCHEDULER_H_
+
+/*
+ *  Project: DogBed
+ *  Description: Small cooperative scheduler, runs each task at its own rate
+ *               from loop() so time only goes to work that is due
+ *  Author: David Barbour
+ */
+
+#include "Particle.h"
+
+class TaskScheduler {
+
+  static const int MAXTASKS = 8;
+
+  struct Task {
+    void (*callback)();
+    unsigned int period;    // ms between runs
+    unsigned int deadline;  // millis() the task is next due
+    bool enabled;
+  };
+
+  Task _tasks[MAXTASKS];
+  int _taskCount;
+
+  public:
+    TaskScheduler() {
+      _taskCount = 0;
+    }
+
+    // returns the task id, or -1 if the table is full
+    int addTask(void (*callback)(), unsigned int period) {
+      if (_taskCount >= MAXTASKS) {
+        return -1;
+      }
+      _tasks[_taskCount].callback = callback;
+      _tasks[_taskCount].period = period;
+      _tasks[_taskCount].deadline = millis();
+      _tasks[_taskCount].enabled = true;
+      return _taskCount++;
+    }
+
+    void setPeriod(int id, unsigned int period) {
+      _tasks[id].period = period;
+    }
+
+    void enableTask(int id, bool enabled) {
+      _tasks[id].enabled = enabled;
+      _tasks[id].deadline = millis();
+    }
+
+    // run every task whose deadline has passed, call this from loop()
+    void run() {
+      unsigned int now;
+
+      for (int i=0; i<_taskCount; i++) {
+        now = millis();
+        if (!_tasks[i].enabled || (int)(now - _tasks[i].deadline) < 0) {
+          continue;
+        }
+        _tasks[i].deadline += _tasks[i].period;
+        // if we fell more than a period behind, don't try to catch up with a burst
+        if ((int)(now - _tasks[i].deadline) >= 0) {
+          _tasks[i].deadline = now + _tasks[i].period;
+        }
+        _tasks[i].callback();
+      }
+    }
+
+    // ms until the next task is due, 0 if one is already late
+    unsigned int nextDue() {
+      unsigned int now = millis();
+      unsigned int soonest = 0xFFFFFFFF;
+      int remaining;
+
+      for (int i=0; i<_taskCount; i++) {
+        if (!_tasks[i].enabled) {
+          continue;
+        }
+        remaining = (int)(_tasks[i].deadline - now);
+        if (remaining <= 0) {
+          return 0;
+        }
+        if ((unsigned int)remaining < soonest) {
+          soonest = remaining;
+        }
+      }
+      return soonest;
+    }
+};
+
+#endif // _TASKSCHEDULER_H_
@@ -0,0 +1,205 @@
+#ifndef _THERMOSTATCONTROL_H_
+#define _THERMOSTATCONTROL_H_
+
+/*
+ *  Project: DogBed
+ *  Description: Thermostat strategies that decide when the fan or heater
+ *               runs. The bed calls whichever one it is given, so they
+ *               can be swapped without touching the state machine
+ *  Author: David Barbour
+ */
+
+#include "Particle.h"
+
+enum ControlAction {
+  ACTION_OFF,
+  ACTION_COOL,
+  ACTION_HEAT
+};
+
+// everything a strategy gets to decide on, temperatures in 1/100 deg F
+struct ControlInput {
+  int32_t temp;
+  int32_t heatingTemp;
+  int32_t coolingTemp;
+  bool occupied;          // the dog is on the bed
+  unsigned int now;       // millis()
+};
+
+struct ControlDecision {
+  ControlAction demand;   // which way the temperature needs to go, if anywhere
+  ControlAction run;      // what the outlets should be doing right now
+};
+
+class ControlStrategy {
+  public:
+    virtual ~ControlStrategy() {}
+
+    virtual ControlDecision decide(const ControlInput &input) = 0;
+
+    // back to off, called while the bed isn't following the temperature,
+    // now is the millis() it let the outlets go
+    virtual void reset(unsigned int now) {}
+
+    // number of times the outlets were told to change
+    virtual unsigned int commands() = 0;
+};
+
+// the original thermostat, straight compares against the setpoints
+class ThresholdControl : public ControlStrategy {
+
+  ControlAction _demand;
+  ControlAction _run;
+  unsigned int _commands;
+
+  public:
+    ThresholdControl() {
+      _commands = 0;
+      _demand = ACTION_OFF;
+      _run = ACTION_OFF;
+    }
+
+    ControlDecision decide(const ControlInput &input) {
+      ControlDecision decision;
+      ControlAction run;
+
+      // between the setpoints the last demand stays
+      if (input.temp < input.heatingTemp) {
+        _demand = ACTION_HEAT;
+      }
+      else if (input.temp >= input.coolingTemp) {
+        _demand = ACTION_COOL;
+      }
+      run = input.occupied ? _demand : ACTION_OFF;
+      if (run != _run) {
+        _run = run;
+        _commands++;
+      }
+      decision.demand = _demand;
+      decision.run = _run;
+      return decision;
+    }
+
+    void reset(unsigned int now) {
+      _demand = ACTION_OFF;
+      _run = ACTION_OFF;
+    }
+
+    unsigned int commands() { return _commands; }
+};
+
+// hysteresis around each setpoint, minimum on and off times, and a cap on
+// how many times the outlets can be switched in a window
+class HysteresisControl : public ControlStrategy {
+
+  static const int MAXCOMMANDS = 8;
+
+  int32_t _deadband;              // how far past the setpoint it runs before stopping
+  unsigned int _minOn;            // ms a fan or heater runs once started
+  unsigned int _minOff;           // ms everything stays off once stopped
+  int _maxCommands;               // no more than this many switches...
+  unsigned int _commandWindow;    // ...in this many ms
+
+  ControlAction _demand;
+  ControlAction _run;
+  bool _dwell;                    // false until the first switch
+  unsigned int _changed;          // millis() of the last switch
+  unsigned int _commandTimes[MAXCOMMANDS];
+  int _nextCommand;
+  int _recentCommands;
+  unsigned int _commands;
+
+  public:
+    HysteresisControl(int32_t deadband, unsigned int minOn, unsigned int minOff, int maxCommands, unsigned int commandWindow) {
+      _deadband = deadband;
+      _minOn = minOn;
+      _minOff = minOff;
+      _maxCommands = (maxCommands < 1) ? 1 : (maxCommands > MAXCOMMANDS) ? MAXCOMMANDS : maxCommands;
+      _commandWindow = commandWindow;
+      _dwell = false;
+      _changed = 0;
+      _nextCommand = 0;
+      _recentCommands = 0;
+      _commands = 0;
+      _demand = ACTION_OFF;
+      _run = ACTION_OFF;
+    }
+
+    ControlDecision decide(const ControlInput &input) {
+      ControlDecision decision;
+      ControlAction wanted;
+
+      _demand = nextDemand(input);
+      wanted = input.occupied ? _demand : ACTION_OFF;
+      if (wanted != _run && canSwitch(input.now)) {
+        _run = wanted;
+        _dwell = true;
+        _changed = input.now;
+        _commandTimes[_nextCommand] = input.now;
+        _nextCommand = (_nextCommand + 1) % _maxCommands;
+        if (_recentCommands < _maxCommands) {_recentCommands++;}
+        _commands++;
+      }
+      decision.demand = _demand;
+      decision.run = _run;
+      return decision;
+    }
+
+    // the switch history is kept, and if something was running the bed
+    // switched it off at now, so the off time starts there. It is called on
+    // every pass outside the running states, once off it leaves _changed alone
+    void reset(unsigned int now) {
+      if (_run != ACTION_OFF) {
+        _dwell = true;
+        _changed = now;
+      }
+      _demand = ACTION_OFF;
+      _run = ACTION_OFF;
+    }
+
+    unsigned int commands() { return _commands; }
+
+  private:
+    ControlAction nextDemand(const ControlInput &input) {
+      // the stop points can't cross, or it would go straight from one to the other
+      int32_t middle = (input.heatingTemp + input.coolingTemp) / 2;
+      int32_t coolOff = input.coolingTemp - _deadband;
+      int32_t heatOff = input.heatingTemp + _deadband;
+
+      if (coolOff < middle) {coolOff = middle;}
+      if (heatOff > middle) {heatOff = middle;}
+
+      if (input.temp < input.heatingTemp) {
+        return ACTION_HEAT;
+      }
+      if (input.temp >= input.coolingTemp) {
+        return ACTION_COOL;
+      }
+      // in between, keep going until it is past the setpoint by the deadband
+      if (_demand == ACTION_COOL && input.temp > coolOff) {
+        return ACTION_COOL;
+      }
+      if (_demand == ACTION_HEAT && input.temp < heatOff) {
+        return ACTION_HEAT;
+      }
+      return ACTION_OFF;
+    }
+
+    bool canSwitch(unsigned int now) {
+      if (_dwell) {
+        if (_run != ACTION_OFF && now - _changed < _minOn) {
+          return false;
+        }
+        if (_run == ACTION_OFF && now - _changed < _minOff) {
+          return false;
+        }
+      }
+      // the oldest of the last _maxCommands switches has to be out of the window
+      if (_recentCommands >= _maxCommands && now - _commandTimes[_nextCommand] < _commandWindow) {
+        return false;
+      }
+      return true;
+    }
+};
+
+#endif // _THERMOSTATCONTROL_H_
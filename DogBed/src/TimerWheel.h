@@ -0,0 +1,216 @@
+#ifndef _TIMERWHEEL_H_
+#define _TIMERWHEEL_H_
+
+/*
+ *  Project: DogBed
+ *  Description: One-shot timers on a hashed timer wheel. Starting, cancelling
+ *               and expiring a timer costs the same no matter how many are
+ *               running, and the loop can ask how long until the next one
+ *  Author: David Barbour
+ */
+
+#include "Particle.h"
+
+/* Usage:
+ * TimerWheel timers;
+ * int id = timers.add(callback, 1000);   // callback() runs once, 1000 ms from now
+ * timers.cancel(id);                     // safe on a timer that already ran, and on -1
+ * timers.run();                          // from loop(), runs every callback that is due
+ * timers.nextDeadline();                 // ms until the next callback, 0xFFFFFFFF if none
+ *
+ * An id is only good until its callback runs, a callback may add timers.
+ * Times are kept as differences of millis(), so they work across its wraparound.
+ */
+
+class TimerWheel {
+
+  static const int SLOTS = 64;        // ticks per turn of the wheel
+  static const int MAXTIMERS = 16;
+  static const int8_t NONE = -1;
+
+  enum TimerState {
+    TIMER_FREE,
+    TIMER_ARMED,    // linked into a slot
+    TIMER_FIRING    // taken off the wheel, callback not run yet
+  };
+
+  struct Timer {
+    void (*callback)();
+    unsigned int due;       // millis() of the tick it runs on
+    unsigned int rounds;    // whole turns of the wheel left before it runs
+    int8_t slot;
+    int8_t next, prev;      // neighbours in the slot, or in the firing list
+    TimerState state;
+  };
+
+  Timer _timers[MAXTIMERS];
+  int8_t _slots[SLOTS];     // first timer in each slot
+  unsigned int _tick;       // ms per slot
+  unsigned int _now;        // millis() of the last tick the wheel was turned to
+  unsigned int _current;    // slot of the last tick
+
+  public:
+    TimerWheel(unsigned int tick=10) {
+      _tick = (tick < 1) ? 1 : tick;
+      _now = 0;
+      _current = 0;
+      for (int i=0; i<SLOTS; i++) {
+        _slots[i] = NONE;
+      }
+      for (int i=0; i<MAXTIMERS; i++) {
+        _timers[i].state = TIMER_FREE;
+      }
+    }
+
+    // start the wheel at the current time, call in setup() before adding timers
+    void begin() {
+      _now = millis();
+    }
+
+    // run callback once, delay ms from now, rounded up to the tick.
+    // Returns the timer id, or -1 if all the timers are in use
+    int add(void (*callback)(), unsigned int delay) {
+      unsigned int ticks;
+      int id;
+
+      id = freeTimer();
+      if (id < 0) {
+        return -1;
+      }
+      // counted from the last tick, which may be a little behind millis()
+      ticks = (millis() - _now + delay + _tick - 1) / _tick;
+      if (ticks < 1) {
+        ticks = 1;
+      }
+      _timers[id].callback = callback;
+      _timers[id].due = _now + ticks * _tick;
+      _timers[id].rounds = (ticks - 1) / SLOTS;
+      _timers[id].slot = (_current + ticks) % SLOTS;
+      _timers[id].state = TIMER_ARMED;
+      link(id);
+      return id;
+    }
+
+    void cancel(int id) {
+      if (id < 0 || id >= MAXTIMERS) {
+        return;
+      }
+      switch (_timers[id].state) {
+        case TIMER_ARMED:
+          unlink(id);
+          _timers[id].state = TIMER_FREE;
+          break;
+
+        case TIMER_FIRING:
+          // still in the firing list, it's freed when run() gets to it
+          _timers[id].callback = NULL;
+          break;
+
+        case TIMER_FREE:
+          break;
+      }
+    }
+
+    // turn the wheel up to now, running the callbacks that came due
+    void run() {
+      unsigned int now = millis();
+
+      while (now - _now >= _tick) {
+        _now += _tick;
+        _current = (_current + 1) % SLOTS;
+        expire(_slots[_current]);
+      }
+    }
+
+    // ms until the next callback is due, 0 if one is late, 0xFFFFFFFF if none are running
+    unsigned int nextDeadline() {
+      unsigned int now = millis();
+      unsigned int soonest = 0xFFFFFFFF;
+      int remaining;
+
+      for (int i=0; i<MAXTIMERS; i++) {
+        if (_timers[i].state != TIMER_ARMED) {
+          continue;
+        }
+        remaining = (int)(_timers[i].due - now);
+        if (remaining <= 0) {
+          return 0;
+        }
+        if ((unsigned int)remaining < soonest) {
+          soonest = remaining;
+        }
+      }
+      return soonest;
+    }
+
+    bool isRunning(int id) {
+      return id >= 0 && id < MAXTIMERS && _timers[id].state == TIMER_ARMED;
+    }
+
+  private:
+    int freeTimer() {
+      for (int i=0; i<MAXTIMERS; i++) {
+        if (_timers[i].state == TIMER_FREE) {
+          return i;
+        }
+      }
+      return -1;
+    }
+
+    void link(int id) {
+      int8_t slot = _timers[id].slot;
+
+      _timers[id].prev = NONE;
+      _timers[id].next = _slots[slot];
+      if (_slots[slot] != NONE) {
+        _timers[_slots[slot]].prev = id;
+      }
+      _slots[slot] = id;
+    }
+
+    void unlink(int id) {
+      Timer &timer = _timers[id];
+
+      if (timer.prev != NONE) {
+        _timers[timer.prev].next = timer.next;
+      }
+      else {
+        _slots[timer.slot] = timer.next;
+      }
+      if (timer.next != NONE) {
+        _timers[timer.next].prev = timer.prev;
+      }
+    }
+
+    // take everything due off the slot first, so the callbacks can add and
+    // cancel timers without pulling the slot apart underneath this
+    void expire(int8_t id) {
+      int8_t next;
+      int8_t firing = NONE;
+
+      while (id != NONE) {
+        next = _timers[id].next;
+        if (_timers[id].rounds > 0) {
+          _timers[id].rounds--;
+        }
+        else {
+          unlink(id);
+          _timers[id].state = TIMER_FIRING;
+          _timers[id].next = firing;
+          firing = id;
+        }
+        id = next;
+      }
+
+      while (firing != NONE) {
+        id = firing;
+        firing = _timers[id].next;
+        _timers[id].state = TIMER_FREE;
+        if (_timers[id].callback != NULL) {
+          _timers[id].callback();
+        }
+      }
+    }
+};
+
+#endif // _TIMERWHEEL_H_